@@ -0,0 +1,159 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "../IntervalTree.h"
+#include "BenchmarkData.h"
+
+//---------------------------------------------------------------------------
+
+static const size_t AggregateTreeSize = 1 << 20; ///< Intervals in the queried tree.
+
+/**
+ * @brief Baseline: counts overlaps by materializing the Overlapping() vector.
+ */
+static void BM_CountByVector(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(AggregateTreeSize, 42);
+  const IntervalTree<int, int> tree(intervals.begin(), intervals.end());
+  const std::vector<Interval<int> > queries = RandomQueries(1024, AggregateTreeSize, static_cast<int>(state.range(0)), 3);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& q = queries[next++ % queries.size()];
+    benchmark::DoNotOptimize(tree.Overlapping(q.low, q.high).size());
+  }
+}
+BENCHMARK(BM_CountByVector)->RangeMultiplier(16)->Range(16, 1 << 16);
+
+/**
+ * @brief CountOverlapping without an augmentation policy: every hit is visited, nothing is allocated.
+ */
+static void BM_CountByVisit(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(AggregateTreeSize, 42);
+  const IntervalTree<int, int> tree(intervals.begin(), intervals.end());
+  const std::vector<Interval<int> > queries = RandomQueries(1024, AggregateTreeSize, static_cast<int>(state.range(0)), 3);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& q = queries[next++ % queries.size()];
+    benchmark::DoNotOptimize(tree.CountOverlapping(q.low, q.high));
+  }
+}
+BENCHMARK(BM_CountByVisit)->RangeMultiplier(16)->Range(16, 1 << 16);
+
+/**
+ * @brief CountOverlapping with SubtreeCount: subtrees inside the query are counted from their summary.
+ */
+static void BM_CountBySummary(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(AggregateTreeSize, 42);
+  const IntervalTree<int, int, SubtreeCount<int> > tree(intervals.begin(), intervals.end());
+  const std::vector<Interval<int> > queries = RandomQueries(1024, AggregateTreeSize, static_cast<int>(state.range(0)), 3);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& q = queries[next++ % queries.size()];
+    benchmark::DoNotOptimize(tree.CountOverlapping(q.low, q.high));
+  }
+}
+BENCHMARK(BM_CountBySummary)->RangeMultiplier(16)->Range(16, 1 << 16);
+
+/**
+ * @brief Total length of the overlapping intervals from SubtreeAggregate summaries.
+ */
+static void BM_LengthBySummary(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(AggregateTreeSize, 42);
+  const IntervalTree<int, int, SubtreeAggregate<int, IntervalLength<int> > > tree(intervals.begin(), intervals.end());
+  const std::vector<Interval<int> > queries = RandomQueries(1024, AggregateTreeSize, static_cast<int>(state.range(0)), 3);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& q = queries[next++ % queries.size()];
+    benchmark::DoNotOptimize(tree.Aggregate(q.low, q.high));
+  }
+}
+BENCHMARK(BM_LengthBySummary)->RangeMultiplier(16)->Range(16, 1 << 16);
+
+/**
+ * @brief Counts overlaps by pulling every hit through OverlapRange, for comparison with BM_CountByVisit.
+ */
+static void BM_CountByRange(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(AggregateTreeSize, 42);
+  const IntervalTree<int, int> tree(intervals.begin(), intervals.end());
+  const std::vector<Interval<int> > queries = RandomQueries(1024, AggregateTreeSize, static_cast<int>(state.range(0)), 3);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& q = queries[next++ % queries.size()];
+    size_t count = 0;
+    for(const Node<int, int>& node : tree.OverlapRange(q.low, q.high))
+    {
+      benchmark::DoNotOptimize(&node);
+      ++count;
+    }
+    benchmark::DoNotOptimize(count);
+  }
+}
+BENCHMARK(BM_CountByRange)->RangeMultiplier(16)->Range(16, 1 << 16);
+
+/**
+ * @brief Takes the eight lowest hits from the sorted Overlapping() vector.
+ */
+static void BM_FirstHitsByVector(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(AggregateTreeSize, 42);
+  const IntervalTree<int, int> tree(intervals.begin(), intervals.end());
+  const std::vector<Interval<int> > queries = RandomQueries(1024, AggregateTreeSize, static_cast<int>(state.range(0)), 3);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& q = queries[next++ % queries.size()];
+    std::vector<std::pair<Interval<int>, int> > hits = tree.Overlapping(q.low, q.high);
+    auto byLow = [](const std::pair<Interval<int>, int>& a, const std::pair<Interval<int>, int>& b)
+    {
+      return a.first.low < b.first.low;
+    };
+    std::partial_sort(hits.begin(), hits.begin() + std::min<size_t>(8, hits.size()), hits.end(), byLow);
+    benchmark::DoNotOptimize(hits.data());
+  }
+}
+BENCHMARK(BM_FirstHitsByVector)->RangeMultiplier(16)->Range(16, 1 << 16);
+
+/**
+ * @brief Takes the eight lowest hits from OverlapRange and abandons the rest of the walk.
+ */
+static void BM_FirstHitsByRange(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(AggregateTreeSize, 42);
+  const IntervalTree<int, int> tree(intervals.begin(), intervals.end());
+  const std::vector<Interval<int> > queries = RandomQueries(1024, AggregateTreeSize, static_cast<int>(state.range(0)), 3);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& q = queries[next++ % queries.size()];
+    size_t taken = 0;
+    for(const Node<int, int>& node : tree.OverlapRange(q.low, q.high))
+    {
+      benchmark::DoNotOptimize(&node);
+      if(++taken == 8)
+      {
+        break;
+      }
+    }
+  }
+}
+BENCHMARK(BM_FirstHitsByRange)->RangeMultiplier(16)->Range(16, 1 << 16);
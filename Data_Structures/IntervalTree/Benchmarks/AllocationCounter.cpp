@@ -0,0 +1,66 @@
+//---------------------------------------------------------------------------
+
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+//---------------------------------------------------------------------------
+
+namespace
+{
+  std::atomic<size_t> liveBytes(0);
+
+  // Every block carries its size in a header so operator delete can subtract it.
+  // The header is as large as max_align_t to keep the returned pointer aligned.
+  const size_t HeaderSize = alignof(std::max_align_t);
+}
+
+size_t AllocatedBytes()
+{
+  return liveBytes.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size)
+{
+  void* block = std::malloc(size + HeaderSize);
+  if(block == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  *static_cast<size_t*>(block) = size;
+  liveBytes.fetch_add(size, std::memory_order_relaxed);
+  return static_cast<char*>(block) + HeaderSize;
+}
+
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+  if(p == nullptr)
+  {
+    return;
+  }
+  void* block = static_cast<char*>(p) - HeaderSize;
+  liveBytes.fetch_sub(*static_cast<size_t*>(block), std::memory_order_relaxed);
+  std::free(block);
+}
+
+void operator delete[](void* p) noexcept
+{
+  operator delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+  operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+  operator delete(p);
+}
@@ -0,0 +1,19 @@
+//---------------------------------------------------------------------------
+
+#ifndef AllocationCounterH
+#define AllocationCounterH
+
+#include <cstddef>
+
+/**
+ * @brief Gets the number of bytes currently allocated through the global operator new.
+ *
+ * The counting operators are defined in AllocationCounter.cpp, which must be
+ * linked into the benchmark binary. The figure covers requested sizes only,
+ * not the allocator's own bookkeeping.
+ *
+ * @return The live heap bytes requested by the program.
+ */
+size_t AllocatedBytes();
+
+#endif
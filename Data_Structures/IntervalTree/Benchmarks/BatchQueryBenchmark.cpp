@@ -0,0 +1,166 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "../IntervalTree.h"
+#include "../ParallelQuery.h"
+#include "../StaticIntervalIndex.h"
+#include "BenchmarkData.h"
+
+//---------------------------------------------------------------------------
+
+namespace
+{
+  const size_t TreeSize = 1 << 21; ///< Large enough that the tree does not fit in L2.
+  const size_t LargeTreeSize = 1 << 22; ///< Large enough that most of a walk misses the last-level cache.
+}
+
+/**
+ * @brief Baseline: answers a batch of state.range(0) points with one Containing call each, gathered into CSR form.
+ */
+static void BM_ContainingOneByOne(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(TreeSize, 42);
+  const IntervalTree<int> tree(intervals.begin(), intervals.end());
+  const std::vector<Interval<int> > queries = RandomQueries(static_cast<size_t>(state.range(0)), TreeSize, 0, 7);
+
+  IntervalBatchResult<int> result;
+  std::vector<std::pair<Interval<int>, std::shared_ptr<int> > > buffer;
+  for(auto _ : state)
+  {
+    result.offsets.assign(1, 0);
+    result.hits.clear();
+    for(const Interval<int>& query : queries)
+    {
+      tree.Containing(query.low, buffer);
+      result.hits.insert(result.hits.end(), buffer.begin(), buffer.end());
+      result.offsets.push_back(result.hits.size());
+    }
+    benchmark::DoNotOptimize(result.hits.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * queries.size()));
+}
+BENCHMARK(BM_ContainingOneByOne)->RangeMultiplier(16)->Range(1 << 8, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief Answers the same batch with the sorted-sweep batch Containing.
+ */
+static void BM_ContainingBatch(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(TreeSize, 42);
+  const IntervalTree<int> tree(intervals.begin(), intervals.end());
+  const std::vector<Interval<int> > queries = RandomQueries(static_cast<size_t>(state.range(0)), TreeSize, 0, 7);
+  std::vector<int> points;
+  for(const Interval<int>& query : queries)
+  {
+    points.push_back(query.low);
+  }
+
+  for(auto _ : state)
+  {
+    IntervalBatchResult<int> result = tree.Containing(points.data(), points.size());
+    benchmark::DoNotOptimize(result.hits.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * points.size()));
+}
+BENCHMARK(BM_ContainingBatch)->RangeMultiplier(16)->Range(1 << 8, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief Baseline for range batches: one Overlapping call per range.
+ */
+static void BM_OverlappingOneByOne(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(TreeSize, 42);
+  const IntervalTree<int> tree(intervals.begin(), intervals.end());
+  const std::vector<Interval<int> > queries = RandomQueries(static_cast<size_t>(state.range(0)), TreeSize, 50, 7);
+
+  IntervalBatchResult<int> result;
+  std::vector<std::pair<Interval<int>, std::shared_ptr<int> > > buffer;
+  for(auto _ : state)
+  {
+    result.offsets.assign(1, 0);
+    result.hits.clear();
+    for(const Interval<int>& query : queries)
+    {
+      tree.Overlapping(query.low, query.high, buffer);
+      result.hits.insert(result.hits.end(), buffer.begin(), buffer.end());
+      result.offsets.push_back(result.hits.size());
+    }
+    benchmark::DoNotOptimize(result.hits.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * queries.size()));
+}
+BENCHMARK(BM_OverlappingOneByOne)->RangeMultiplier(16)->Range(1 << 8, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief Answers the same range batch with the sorted-sweep batch Overlapping.
+ */
+static void BM_OverlappingBatch(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(TreeSize, 42);
+  const IntervalTree<int> tree(intervals.begin(), intervals.end());
+  const std::vector<Interval<int> > queries = RandomQueries(static_cast<size_t>(state.range(0)), TreeSize, 50, 7);
+
+  for(auto _ : state)
+  {
+    IntervalBatchResult<int> result = tree.Overlapping(queries.data(), queries.size());
+    benchmark::DoNotOptimize(result.hits.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * queries.size()));
+}
+BENCHMARK(BM_OverlappingBatch)->RangeMultiplier(16)->Range(1 << 8, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief Answers a batch of 1M points with ParallelQuery on state.range(0) worker threads.
+ */
+static void BM_ContainingParallel(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(TreeSize, 42);
+  const IntervalTree<int> tree(intervals.begin(), intervals.end());
+  const std::vector<Interval<int> > queries = RandomQueries(1 << 20, TreeSize, 0, 7);
+  std::vector<int> points;
+  for(const Interval<int>& query : queries)
+  {
+    points.push_back(query.low);
+  }
+
+  const ParallelQuery<int> parallel(tree, static_cast<unsigned>(state.range(0)));
+  for(auto _ : state)
+  {
+    IntervalBatchResult<int> result = parallel.Containing(points.data(), points.size());
+    benchmark::DoNotOptimize(result.hits.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * points.size()));
+}
+BENCHMARK(BM_ContainingParallel)->RangeMultiplier(2)->Range(1, 16)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/**
+ * @brief Answers 64K scattered points on a large tree or static index with state.range(0) interleaved walks in flight.
+ *
+ * One walk in flight is the plain per-point walk, so it is the baseline for the other group sizes.
+ */
+template <typename Index>
+static void BM_ContainingInterleaved(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(LargeTreeSize, 42);
+  const IntervalTree<int> tree(intervals.begin(), intervals.end());
+  const Index index(tree);
+  const std::vector<Interval<int> > queries = RandomQueries(1 << 16, LargeTreeSize, 0, 7);
+  std::vector<int> points;
+  for(const Interval<int>& query : queries)
+  {
+    points.push_back(query.low);
+  }
+
+  const size_t group = static_cast<size_t>(state.range(0));
+  for(auto _ : state)
+  {
+    IntervalBatchResult<int> result = index.ContainingInterleaved(points.data(), points.size(), group);
+    benchmark::DoNotOptimize(result.hits.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * points.size()));
+}
+BENCHMARK_TEMPLATE(BM_ContainingInterleaved, IntervalTree<int>)->RangeMultiplier(4)->Range(1, 64)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ContainingInterleaved, StaticIntervalIndex<int>)->RangeMultiplier(4)->Range(1, 64)->Unit(benchmark::kMillisecond);
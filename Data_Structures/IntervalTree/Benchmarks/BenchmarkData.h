@@ -0,0 +1,140 @@
+//---------------------------------------------------------------------------
+
+#ifndef BenchmarkDataH
+#define BenchmarkDataH
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "../IntervalTree.h"
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Generates a reproducible set of random intervals.
+ * @param count The number of intervals to generate.
+ * @param seed The seed for the pseudo-random generator.
+ * @return A vector of intervals with lows uniformly spread over [0, 10 * count] and lengths in [0, 100].
+ */
+inline std::vector<Interval<int> > RandomIntervals(size_t count, unsigned seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> lowDist(0, static_cast<int>(count * 10));
+  std::uniform_int_distribution<int> lengthDist(0, 100);
+
+  std::vector<Interval<int> > intervals;
+  intervals.reserve(count);
+  for(size_t n = 0; n < count; ++n)
+  {
+    int low = lowDist(rng);
+    intervals.push_back(Interval<int>(low, low + lengthDist(rng)));
+  }
+  return intervals;
+}
+
+/**
+ * @brief Generates reproducible query ranges spread over the key space of RandomIntervals(treeSize, ...).
+ * @param count The number of queries to generate.
+ * @param treeSize The size of the tree being queried.
+ * @param maxLength The maximum query length; zero gives point queries.
+ * @param seed The seed for the pseudo-random generator.
+ * @return A vector of query ranges.
+ */
+inline std::vector<Interval<int> > RandomQueries(size_t count, size_t treeSize, int maxLength, unsigned seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> lowDist(0, static_cast<int>(treeSize * 10));
+  std::uniform_int_distribution<int> lengthDist(0, maxLength);
+
+  std::vector<Interval<int> > queries;
+  queries.reserve(count);
+  for(size_t n = 0; n < count; ++n)
+  {
+    int low = lowDist(rng);
+    queries.push_back(Interval<int>(low, low + lengthDist(rng)));
+  }
+  return queries;
+}
+
+/**
+ * @brief Identifies an interval distribution in benchmark arguments.
+ */
+enum IntervalDistribution
+{
+  UniformDistribution = 0, ///< RandomIntervals.
+  ClusteredDistribution = 1, ///< ClusteredIntervals.
+  NestedDistribution = 2 ///< NestedIntervals.
+};
+
+/**
+ * @brief Generates intervals bunched around a few hot spots, like requests around popular keys.
+ * @param count The number of intervals to generate.
+ * @param seed The seed for the pseudo-random generator.
+ * @return A vector of intervals over [0, 10 * count] whose lows sit in 16 narrow clusters, with lengths in [0, 100].
+ */
+inline std::vector<Interval<int> > ClusteredIntervals(size_t count, unsigned seed)
+{
+  std::mt19937 rng(seed);
+  const int span = static_cast<int>(count * 10);
+  std::uniform_int_distribution<int> centerDist(0, span);
+  std::vector<int> centers(16);
+  for(size_t c = 0; c < centers.size(); ++c)
+  {
+    centers[c] = centerDist(rng);
+  }
+  std::uniform_int_distribution<size_t> clusterDist(0, centers.size() - 1);
+  std::normal_distribution<double> offsetDist(0.0, span / 1000.0 + 1.0);
+  std::uniform_int_distribution<int> lengthDist(0, 100);
+
+  std::vector<Interval<int> > intervals;
+  intervals.reserve(count);
+  for(size_t n = 0; n < count; ++n)
+  {
+    int low = std::min(span, std::max(0, centers[clusterDist(rng)] + static_cast<int>(offsetDist(rng))));
+    intervals.push_back(Interval<int>(low, low + lengthDist(rng)));
+  }
+  return intervals;
+}
+
+/**
+ * @brief Generates intervals whose lengths span every scale, so long intervals contain many short ones.
+ * @param count The number of intervals to generate.
+ * @param seed The seed for the pseudo-random generator.
+ * @return A vector of intervals centered uniformly over [0, 10 * count], with half-lengths 2^k for k uniform in [0, 12].
+ *         A point lies in about 125 of them at any size, most of them long.
+ */
+inline std::vector<Interval<int> > NestedIntervals(size_t count, unsigned seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> centerDist(0, static_cast<int>(count * 10));
+  std::uniform_int_distribution<int> levelDist(0, 12);
+
+  std::vector<Interval<int> > intervals;
+  intervals.reserve(count);
+  for(size_t n = 0; n < count; ++n)
+  {
+    int center = centerDist(rng);
+    int half = 1 << levelDist(rng);
+    intervals.push_back(Interval<int>(center - half, center + half));
+  }
+  return intervals;
+}
+
+/**
+ * @brief Generates count intervals of the given distribution.
+ */
+inline std::vector<Interval<int> > MakeIntervals(IntervalDistribution distribution, size_t count, unsigned seed)
+{
+  switch(distribution)
+  {
+    case ClusteredDistribution:
+      return ClusteredIntervals(count, seed);
+    case NestedDistribution:
+      return NestedIntervals(count, seed);
+    default:
+      return RandomIntervals(count, seed);
+  }
+}
+
+#endif
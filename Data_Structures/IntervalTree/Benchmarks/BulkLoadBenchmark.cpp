@@ -0,0 +1,49 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "../IntervalTree.h"
+#include "BenchmarkData.h"
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Baseline: builds the tree with one rebalancing Insert per interval.
+ */
+static void BM_BuildByInsert(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+
+  for(auto _ : state)
+  {
+    IntervalTree<int> tree;
+    for(const Interval<int>& i : intervals)
+    {
+      tree.Insert(i);
+    }
+    benchmark::DoNotOptimize(tree.Size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK(BM_BuildByInsert)->RangeMultiplier(8)->Range(1 << 12, 1 << 21)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Builds the tree with the bulk-load constructor; state.range(1) selects the parallel sort.
+ */
+static void BM_BuildByBulkLoad(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const bool parallel = state.range(1) != 0;
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+
+  for(auto _ : state)
+  {
+    IntervalTree<int> tree(intervals.begin(), intervals.end(), parallel);
+    benchmark::DoNotOptimize(tree.Size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK(BM_BuildByBulkLoad)->ArgsProduct({benchmark::CreateRange(1 << 12, 1 << 21, 8), {0, 1}})->Unit(benchmark::kMillisecond);
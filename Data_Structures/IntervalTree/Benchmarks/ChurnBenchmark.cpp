@@ -0,0 +1,134 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "../IntervalTree.h"
+#include "../DisjointIntervalSet.h"
+#include "BenchmarkData.h"
+
+//---------------------------------------------------------------------------
+
+static const size_t ChurnTreeSize = 1 << 16; ///< Intervals kept live in the steady state.
+
+/**
+ * @brief Replaces rounds * ChurnTreeSize random live intervals, one Remove and one Insert at a time.
+ */
+static void Churn(IntervalTree<int>& tree, std::vector<Interval<int> >& live, size_t rounds, unsigned seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<size_t> pick(0, live.size() - 1);
+  for(size_t r = 0; r < rounds; ++r)
+  {
+    // One batch per round keeps the replacements in the key space of the initial intervals
+    const std::vector<Interval<int> > fresh = RandomIntervals(live.size(), seed + static_cast<unsigned>(r));
+    for(const Interval<int>& i : fresh)
+    {
+      size_t victim = pick(rng);
+      tree.Remove(live[victim]);
+      tree.Insert(i);
+      live[victim] = i;
+    }
+  }
+}
+
+/**
+ * @brief Measures Overlapping latency after state.range(0) rounds of insert/delete churn.
+ *
+ * Remove rebalances like Insert, so the height counter stays near
+ * 1.44 log2(n) and the latency stays flat however long the churn runs.
+ * Either one growing with the number of rounds means deletes have stopped
+ * restoring the AVL invariant.
+ */
+static void BM_QueryAfterChurn(benchmark::State& state)
+{
+  std::vector<Interval<int> > live = RandomIntervals(ChurnTreeSize, 42);
+  IntervalTree<int> tree(live.begin(), live.end());
+  Churn(tree, live, static_cast<size_t>(state.range(0)), 7);
+  const std::vector<Interval<int> > queries = RandomQueries(1024, ChurnTreeSize, 100, 3);
+
+  std::vector<std::pair<Interval<int>, std::shared_ptr<int> > > result;
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& q = queries[next++ % queries.size()];
+    tree.Overlapping(q.low, q.high, result);
+    benchmark::DoNotOptimize(result.data());
+  }
+  state.counters["height"] = tree.Height();
+}
+BENCHMARK(BM_QueryAfterChurn)->Arg(0)->Arg(1)->Arg(4)->Arg(16);
+
+/**
+ * @brief Measures the throughput of steady-state churn, one Remove plus one Insert per item.
+ */
+static void BM_ChurnStep(benchmark::State& state)
+{
+  std::vector<Interval<int> > live = RandomIntervals(ChurnTreeSize, 42);
+  IntervalTree<int> tree(live.begin(), live.end());
+  const std::vector<Interval<int> > fresh = RandomIntervals(ChurnTreeSize, 11);
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<size_t> pick(0, live.size() - 1);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    size_t victim = pick(rng);
+    tree.Remove(live[victim]);
+    live[victim] = fresh[next++ % fresh.size()];
+    tree.Insert(live[victim]);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["height"] = tree.Height();
+}
+BENCHMARK(BM_ChurnStep);
+
+/**
+ * @brief Measures Overlapping latency on a tree after state.range(0) clustered reservations, one node per reservation.
+ */
+static void BM_ReservedByTree(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > reservations = ClusteredIntervals(count, 42);
+  IntervalTree<int, int> tree;
+  for(const Interval<int>& i : reservations)
+  {
+    tree.Insert(i);
+  }
+  const std::vector<Interval<int> > queries = RandomQueries(1024, count, 100, 3);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& q = queries[next++ % queries.size()];
+    benchmark::DoNotOptimize(tree.Overlapping(q.low, q.high));
+  }
+  state.counters["nodes"] = static_cast<double>(tree.Size());
+}
+BENCHMARK(BM_ReservedByTree)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+
+/**
+ * @brief Baseline for BM_ReservedByTree: the same reservations coalesced by a DisjointIntervalSet.
+ */
+static void BM_ReservedBySet(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > reservations = ClusteredIntervals(count, 42);
+  DisjointIntervalSet<int> set;
+  for(const Interval<int>& i : reservations)
+  {
+    set.Insert(i);
+  }
+  const std::vector<Interval<int> > queries = RandomQueries(1024, count, 100, 3);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& q = queries[next++ % queries.size()];
+    benchmark::DoNotOptimize(set.Overlapping(q.low, q.high));
+  }
+  state.counters["nodes"] = static_cast<double>(set.Size());
+}
+BENCHMARK(BM_ReservedBySet)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
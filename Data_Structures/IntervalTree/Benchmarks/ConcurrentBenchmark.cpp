@@ -0,0 +1,100 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../ConcurrentIntervalTree.h"
+#include "BenchmarkData.h"
+
+//---------------------------------------------------------------------------
+
+static const size_t ConcurrentSize = 1 << 20; ///< Intervals in the tree the readers query.
+
+/**
+ * @brief Times point queries on the benchmark thread while a second thread keeps writing.
+ *
+ * The writer moves one interval by one per call, so the tree keeps its size
+ * and shape for the whole run. Reports the median and p99 query latency in
+ * nanoseconds, and the writes the burst completed per second.
+ *
+ * @param state The benchmark state.
+ * @param query Called as query(value) by the reader.
+ * @param update Called as update(oldInterval, newInterval) by the writer.
+ */
+template <typename Query, typename Update>
+static void ReadDuringWrites(benchmark::State& state, Query query, Update update)
+{
+  std::vector<Interval<int> > current = RandomIntervals(ConcurrentSize, 42);
+  const std::vector<Interval<int> > probes = RandomQueries(1 << 16, ConcurrentSize, 0, 3);
+  std::atomic<bool> stop(false);
+  std::atomic<size_t> writes(0);
+
+  std::thread writer([&]()
+  {
+    size_t next = 0;
+    while(!stop.load(std::memory_order_relaxed))
+    {
+      Interval<int>& i = current[next++ % current.size()];
+      Interval<int> moved(i.low + 1, i.high + 1);
+      update(i, moved);
+      i = moved;
+      writes.store(next, std::memory_order_relaxed);
+    }
+  });
+
+  std::vector<double> latencies;
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    benchmark::DoNotOptimize(query(probes[next++ % probes.size()].low));
+    latencies.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+  }
+
+  stop = true;
+  writer.join();
+
+  std::sort(latencies.begin(), latencies.end());
+  state.counters["p50_ns"] = latencies[latencies.size() / 2];
+  state.counters["p99_ns"] = latencies[latencies.size() * 99 / 100];
+  state.counters["writes"] = benchmark::Counter(static_cast<double>(writes.load()), benchmark::Counter::kIsRate);
+}
+
+/**
+ * @brief Lock-free Contains on a ConcurrentIntervalTree of 1M intervals while another thread calls Update.
+ */
+static void BM_ConcurrentReadDuringWrites(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(ConcurrentSize, 42);
+  ConcurrentIntervalTree<int> tree;
+  for(size_t n = 0; n < intervals.size(); ++n)
+  {
+    tree.Insert(intervals[n]);
+  }
+
+  ReadDuringWrites(state,
+                   [&](int value) { return tree.Contains(value); },
+                   [&](const Interval<int>& from, const Interval<int>& to) { tree.Update(from, to); });
+}
+BENCHMARK(BM_ConcurrentReadDuringWrites)->UseRealTime();
+
+/**
+ * @brief Baseline: the same workload on an IntervalTree behind one mutex, as before ConcurrentIntervalTree.
+ */
+static void BM_LockedReadDuringWrites(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(ConcurrentSize, 42);
+  IntervalTree<int> tree(intervals.begin(), intervals.end());
+  std::mutex lock;
+
+  ReadDuringWrites(state,
+                   [&](int value) { std::lock_guard<std::mutex> guard(lock); return tree.Contains(value); },
+                   [&](const Interval<int>& from, const Interval<int>& to) { std::lock_guard<std::mutex> guard(lock); tree.Update(from, to); });
+}
+BENCHMARK(BM_LockedReadDuringWrites)->UseRealTime();
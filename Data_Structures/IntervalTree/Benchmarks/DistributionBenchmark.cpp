@@ -0,0 +1,219 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "../IntervalTree.h"
+#include "BenchmarkData.h"
+
+//---------------------------------------------------------------------------
+
+namespace
+{
+  const size_t QueryCount = 4096; ///< Queries are cycled so every size sees the same mix.
+
+  /**
+   * @brief Baseline index: intervals sorted by low, searched between low - longest and high.
+   *
+   * Every interval that overlaps [low, high] starts in that window, so one
+   * binary search and a scan answer a query. The window grows with the
+   * longest interval, which is what nested distributions punish.
+   */
+  class SortedVectorIndex
+  {
+    public:
+      explicit SortedVectorIndex(const std::vector<Interval<int> >& intervals) : sorted(intervals), longest(0)
+      {
+        std::sort(sorted.begin(), sorted.end(), [](const Interval<int>& a, const Interval<int>& b)
+        {
+          return a.low < b.low;
+        });
+        for(size_t n = 0; n < sorted.size(); ++n)
+        {
+          longest = std::max(longest, sorted[n].high - sorted[n].low);
+        }
+      }
+
+      template <typename Visitor>
+      void ForEachOverlapping(int low, int high, Visitor visit) const
+      {
+        std::vector<Interval<int> >::const_iterator it = std::lower_bound(sorted.begin(), sorted.end(), low - longest,
+          [](const Interval<int>& i, int key)
+          {
+            return i.low < key;
+          });
+        for(; it != sorted.end() && it->low <= high; ++it)
+        {
+          if(it->high >= low && !IntervalTreeDetail::Visit(visit, *it))
+          {
+            return;
+          }
+        }
+      }
+
+      std::vector<Interval<int> > Overlapping(int low, int high) const
+      {
+        std::vector<Interval<int> > result;
+        ForEachOverlapping(low, high, [&result](const Interval<int>& i)
+        {
+          result.push_back(i);
+        });
+        return result;
+      }
+
+      std::vector<Interval<int> > Containing(int value) const
+      {
+        return Overlapping(value, value);
+      }
+
+      bool Contains(int value) const
+      {
+        bool found = false;
+        ForEachOverlapping(value, value, [&found](const Interval<int>&)
+        {
+          found = true;
+          return false;
+        });
+        return found;
+      }
+
+    private:
+      std::vector<Interval<int> > sorted; ///< The intervals in ascending order of low.
+      int longest; ///< The greatest high - low.
+  };
+
+  /**
+   * @brief Builds a tree or the baseline from generated intervals.
+   */
+  template <typename Index>
+  Index Make(const std::vector<Interval<int> >& intervals)
+  {
+    return Index(intervals);
+  }
+
+  template <>
+  IntervalTree<int, int> Make<IntervalTree<int, int> >(const std::vector<Interval<int> >& intervals)
+  {
+    return IntervalTree<int, int>(intervals.begin(), intervals.end());
+  }
+
+  typedef IntervalTree<int, int, NoAugmentation, QueryStats> CountingTree; ///< The tree with its statistics switched on.
+
+  template <>
+  CountingTree Make<CountingTree>(const std::vector<Interval<int> >& intervals)
+  {
+    return CountingTree(intervals.begin(), intervals.end());
+  }
+
+  /**
+   * @brief Registers sizes 4K to 1M for each of the three distributions.
+   */
+  void Sizes(benchmark::internal::Benchmark* b)
+  {
+    for(int distribution = UniformDistribution; distribution <= NestedDistribution; ++distribution)
+    {
+      for(int count = 1 << 12; count <= 1 << 20; count <<= 4)
+      {
+        b->Args({ count, distribution });
+      }
+    }
+    b->ArgNames({ "n", "distribution" });
+  }
+}
+
+/**
+ * @brief Measures Contains latency; state.range(1) selects the IntervalDistribution.
+ */
+template <typename Index>
+static void BM_DistributionContains(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const IntervalDistribution distribution = static_cast<IntervalDistribution>(state.range(1));
+  const Index index = Make<Index>(MakeIntervals(distribution, count, 42));
+  const std::vector<Interval<int> > queries = RandomQueries(QueryCount, count, 0, 7);
+
+  size_t q = 0;
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(index.Contains(queries[q++ % QueryCount].low));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK_TEMPLATE(BM_DistributionContains, IntervalTree<int, int>)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_DistributionContains, CountingTree)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_DistributionContains, SortedVectorIndex)->Apply(Sizes);
+
+/**
+ * @brief Measures Containing latency, hits copied out; state.range(1) selects the IntervalDistribution.
+ */
+template <typename Index>
+static void BM_DistributionContaining(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const IntervalDistribution distribution = static_cast<IntervalDistribution>(state.range(1));
+  const Index index = Make<Index>(MakeIntervals(distribution, count, 42));
+  const std::vector<Interval<int> > queries = RandomQueries(QueryCount, count, 0, 7);
+
+  size_t q = 0;
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(index.Containing(queries[q++ % QueryCount].low));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK_TEMPLATE(BM_DistributionContaining, IntervalTree<int, int>)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_DistributionContaining, CountingTree)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_DistributionContaining, SortedVectorIndex)->Apply(Sizes);
+
+/**
+ * @brief Measures Overlapping latency for queries up to 1000 wide; state.range(1) selects the IntervalDistribution.
+ */
+template <typename Index>
+static void BM_DistributionOverlapping(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const IntervalDistribution distribution = static_cast<IntervalDistribution>(state.range(1));
+  const Index index = Make<Index>(MakeIntervals(distribution, count, 42));
+  const std::vector<Interval<int> > queries = RandomQueries(QueryCount, count, 1000, 7);
+
+  size_t q = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& query = queries[q++ % QueryCount];
+    benchmark::DoNotOptimize(index.Overlapping(query.low, query.high));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK_TEMPLATE(BM_DistributionOverlapping, IntervalTree<int, int>)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_DistributionOverlapping, CountingTree)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_DistributionOverlapping, SortedVectorIndex)->Apply(Sizes);
+
+/**
+ * @brief Reports the nodes visited, subtrees pruned and hits per Overlapping query from the tree statistics.
+ *
+ * The time is that of BM_DistributionOverlapping on CountingTree; the
+ * counters show how much of the tree each distribution makes a query walk.
+ */
+static void BM_DistributionWork(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const IntervalDistribution distribution = static_cast<IntervalDistribution>(state.range(1));
+  const CountingTree tree = Make<CountingTree>(MakeIntervals(distribution, count, 42));
+  const std::vector<Interval<int> > queries = RandomQueries(QueryCount, count, 1000, 7);
+
+  size_t q = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& query = queries[q++ % QueryCount];
+    tree.ForEachOverlapping(query.low, query.high, [](const Interval<int>&, int) {});
+  }
+  const IntervalTreeStats stats = tree.Stats();
+  const double perQuery = static_cast<double>(stats.queries);
+  state.counters["visited"] = static_cast<double>(stats.nodesVisited) / perQuery;
+  state.counters["pruned"] = static_cast<double>(stats.subtreesPruned) / perQuery;
+  state.counters["hits"] = static_cast<double>(stats.results) / perQuery;
+  state.counters["height"] = static_cast<double>(stats.depths.size());
+}
+BENCHMARK(BM_DistributionWork)->Apply(Sizes);
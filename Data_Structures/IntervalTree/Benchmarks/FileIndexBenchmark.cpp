@@ -0,0 +1,85 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../IntervalTree.h"
+#include "../StaticIntervalIndex.h"
+#include "../MappedIntervalIndex.h"
+#include "BenchmarkData.h"
+
+//---------------------------------------------------------------------------
+
+namespace
+{
+  const char* const IndexPath = "interval_index_bench.bin"; ///< Written to the working directory and removed afterwards.
+
+  /**
+   * @brief Builds and saves an index of count intervals, with each interval's position as its payload.
+   */
+  std::vector<std::pair<Interval<int>, int> > SaveIndex(size_t count)
+  {
+    const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+    std::vector<std::pair<Interval<int>, int> > entries;
+    entries.reserve(count);
+    for(size_t n = 0; n < count; ++n)
+    {
+      entries.push_back(std::make_pair(intervals[n], static_cast<int>(n)));
+    }
+    StaticIntervalIndex<int, int>(entries.begin(), entries.end()).Save(IndexPath);
+    return entries;
+  }
+}
+
+/**
+ * @brief Baseline start-up: inserts every interval into a tree and freezes it.
+ */
+static void BM_StartByBuild(benchmark::State& state)
+{
+  const std::vector<std::pair<Interval<int>, int> > entries = SaveIndex(static_cast<size_t>(state.range(0)));
+  for(auto _ : state)
+  {
+    IntervalTree<int, int> tree;
+    for(size_t n = 0; n < entries.size(); ++n)
+    {
+      tree.Insert(entries[n].first, entries[n].second);
+    }
+    const StaticIntervalIndex<int, int> index(tree);
+    benchmark::DoNotOptimize(index.Contains(1));
+  }
+  std::remove(IndexPath);
+}
+BENCHMARK(BM_StartByBuild)->RangeMultiplier(16)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Reads the saved arrays into a StaticIntervalIndex.
+ */
+static void BM_StartByLoad(benchmark::State& state)
+{
+  SaveIndex(static_cast<size_t>(state.range(0)));
+  for(auto _ : state)
+  {
+    const StaticIntervalIndex<int, int> index = StaticIntervalIndex<int, int>::Load(IndexPath);
+    benchmark::DoNotOptimize(index.Contains(1));
+  }
+  std::remove(IndexPath);
+}
+BENCHMARK(BM_StartByLoad)->RangeMultiplier(16)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Maps the saved file and answers one query in place.
+ */
+static void BM_StartByMap(benchmark::State& state)
+{
+  SaveIndex(static_cast<size_t>(state.range(0)));
+  for(auto _ : state)
+  {
+    const MappedIntervalIndex<int, int> index(IndexPath);
+    benchmark::DoNotOptimize(index.Contains(1));
+  }
+  std::remove(IndexPath);
+}
+BENCHMARK(BM_StartByMap)->RangeMultiplier(16)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMillisecond);
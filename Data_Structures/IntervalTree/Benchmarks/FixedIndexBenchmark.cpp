@@ -0,0 +1,85 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "../FixedIntervalIndex.h"
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief The port classes from the README; building and querying them here keeps the constexpr path compiling.
+ */
+static constexpr std::pair<Interval<int>, int> Ports[] = {
+  { Interval<int>(0, 1023), 0 },      // Well-known
+  { Interval<int>(1024, 49151), 1 },  // Registered
+  { Interval<int>(49152, 65535), 2 }  // Dynamic
+};
+static constexpr FixedIntervalIndex<int, int, 3> PortClasses(Ports);
+static_assert(PortClasses.Find(443, -1) == 0, "HTTPS is a well-known port");
+static_assert(PortClasses.Find(8080, -1) == 1, "8080 is a registered port");
+static_assert(PortClasses.Find(65536, -1) == -1, "65536 is not a port");
+static_assert(MakeFixedIntervalIndex(Ports).Contains(49152), "MakeFixedIntervalIndex builds the same index");
+
+/**
+ * @brief The example from the FixedIntervalIndex doc comment.
+ */
+static constexpr std::pair<Interval<int>, int> DocPorts[] = { { Interval<int>(0, 1023), 0 }, { Interval<int>(1024, 49151), 1 } };
+static constexpr FixedIntervalIndex<int, int, 2> DocIndex(DocPorts);
+static_assert(DocIndex.Find(80, -1) == 0, "well-known port");
+
+/**
+ * @brief Generates reproducible port numbers, a few of them past the last class.
+ */
+static std::vector<int> RandomPorts(size_t count)
+{
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<int> portDist(0, 70000);
+
+  std::vector<int> ports(count);
+  for(size_t n = 0; n < count; ++n)
+  {
+    ports[n] = portDist(rng);
+  }
+  return ports;
+}
+
+/**
+ * @brief Classifies ports through the constexpr FixedIntervalIndex.
+ */
+static void BM_FixedFind(benchmark::State& state)
+{
+  const std::vector<int> ports = RandomPorts(1024);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(PortClasses.Find(ports[next++ % ports.size()], -1));
+  }
+}
+BENCHMARK(BM_FixedFind);
+
+/**
+ * @brief Baseline: the same classification with an IntervalTree built at run time.
+ */
+static void BM_TreeFind(benchmark::State& state)
+{
+  const std::vector<int> ports = RandomPorts(1024);
+  IntervalTree<int, int> tree;
+  for(const std::pair<Interval<int>, int>& entry : Ports)
+  {
+    tree.Insert(entry.first, entry.second);
+  }
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    int found = -1;
+    int port = ports[next++ % ports.size()];
+    tree.ForEachOverlapping(port, port, [&](const Interval<int>&, int value) { found = value; return false; });
+    benchmark::DoNotOptimize(found);
+  }
+}
+BENCHMARK(BM_TreeFind);
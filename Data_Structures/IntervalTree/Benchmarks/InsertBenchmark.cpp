@@ -0,0 +1,155 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "../IntervalTree.h"
+#include "../BufferedIntervalTree.h"
+#include "BenchmarkData.h"
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Measures insert throughput while building a tree of state.range(0) intervals.
+ *
+ * With cached subtree heights each insert is O(log n), so items_per_second
+ * should only drop slowly as the tree grows. A sharp fall-off with size is
+ * the signature of an O(n) balance computation creeping back in.
+ */
+static void BM_InsertRandom(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+
+  for(auto _ : state)
+  {
+    IntervalTree<int> tree;
+    for(const Interval<int>& i : intervals)
+    {
+      tree.Insert(i);
+    }
+    benchmark::DoNotOptimize(tree.Size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK(BM_InsertRandom)->RangeMultiplier(4)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Measures insert throughput for ascending lows, the worst case for rebalancing.
+ */
+static void BM_InsertAscending(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+
+  for(auto _ : state)
+  {
+    IntervalTree<int> tree;
+    for(size_t n = 0; n < count; ++n)
+    {
+      int low = static_cast<int>(n);
+      tree.Insert(low, low + 10);
+    }
+    benchmark::DoNotOptimize(tree.Size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK(BM_InsertAscending)->RangeMultiplier(4)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Measures the throughput of a burst of state.range(0) inserts into a BufferedIntervalTree, final Flush() included.
+ *
+ * state.range(1) is the buffer capacity. Compare with BM_InsertRandom at the
+ * same size: the larger the capacity, the more of the burst is merged by bulk
+ * loads instead of one rebalancing insert at a time.
+ */
+static void BM_InsertBuffered(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+
+  for(auto _ : state)
+  {
+    BufferedIntervalTree<int> tree(static_cast<size_t>(state.range(1)));
+    for(const Interval<int>& i : intervals)
+    {
+      tree.Insert(i);
+    }
+    tree.Flush();
+    benchmark::DoNotOptimize(tree.Size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK(BM_InsertBuffered)->ArgsProduct({ { 1 << 16, 1 << 20 }, { 1 << 12, 1 << 16, 1 << 30 } })->ArgNames({ "n", "capacity" })->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Measures remove throughput while emptying a tree of state.range(0) intervals in random order.
+ */
+static void BM_RemoveRandom(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  std::vector<Interval<int> > order = intervals;
+  std::shuffle(order.begin(), order.end(), std::mt19937(7));
+
+  for(auto _ : state)
+  {
+    state.PauseTiming();
+    IntervalTree<int, int> tree(intervals.begin(), intervals.end());
+    state.ResumeTiming();
+    for(const Interval<int>& i : order)
+    {
+      tree.Remove(i);
+    }
+    benchmark::DoNotOptimize(tree.Size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK(BM_RemoveRandom)->RangeMultiplier(4)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Measures Update when only high changes, which fixes max along one path in place.
+ */
+static void BM_UpdateHigh(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  IntervalTree<int, int> tree(intervals.begin(), intervals.end());
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    Interval<int>& i = intervals[next];
+    Interval<int> moved(i.low, i.high + 1);
+    tree.Update(i, moved, static_cast<int>(next));
+    i = moved;
+    next = (next + 1) % count;
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_UpdateHigh)->RangeMultiplier(16)->Range(1 << 10, 1 << 20);
+
+/**
+ * @brief Baseline for BM_UpdateHigh: the same changes made by a Remove and an Insert.
+ */
+static void BM_UpdateByReinsert(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  IntervalTree<int, int> tree(intervals.begin(), intervals.end());
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    Interval<int>& i = intervals[next];
+    Interval<int> moved(i.low, i.high + 1);
+    tree.Remove(i);
+    tree.Insert(moved, static_cast<int>(next));
+    i = moved;
+    next = (next + 1) % count;
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_UpdateByReinsert)->RangeMultiplier(16)->Range(1 << 10, 1 << 20);
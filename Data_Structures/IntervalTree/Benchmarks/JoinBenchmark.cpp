@@ -0,0 +1,138 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "../IntervalTree.h"
+#include "../IntervalJoin.h"
+#include "AllocationCounter.h"
+#include "BenchmarkData.h"
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Baseline: one ForEachOverlapping query on B per interval of A.
+ */
+static void BM_JoinByQueries(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > left = RandomIntervals(count, 42);
+  const std::vector<Interval<int> > right = RandomIntervals(count, 43);
+  const IntervalTree<int, int> a(left.begin(), left.end());
+  const IntervalTree<int, int> b(right.begin(), right.end());
+  const std::vector<std::pair<Interval<int>, int> > probes = a.Intervals();
+
+  size_t pairs = 0;
+  for(auto _ : state)
+  {
+    pairs = 0;
+    for(size_t n = 0; n < probes.size(); ++n)
+    {
+      b.ForEachOverlapping(probes[n].first.low, probes[n].first.high, [&pairs](const Interval<int>&, const int&)
+      {
+        ++pairs;
+      });
+    }
+    benchmark::DoNotOptimize(pairs);
+  }
+  state.counters["pairs"] = static_cast<double>(pairs);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK(BM_JoinByQueries)->RangeMultiplier(8)->Range(1 << 12, 1 << 18)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief OverlapJoin over both trees: one simultaneous in-order walk.
+ */
+static void BM_JoinBySweep(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > left = RandomIntervals(count, 42);
+  const std::vector<Interval<int> > right = RandomIntervals(count, 43);
+  const IntervalTree<int, int> a(left.begin(), left.end());
+  const IntervalTree<int, int> b(right.begin(), right.end());
+
+  size_t pairs = 0;
+  for(auto _ : state)
+  {
+    pairs = 0;
+    OverlapJoin(a, b, [&pairs](const Interval<int>&, const int&, const Interval<int>&, const int&)
+    {
+      ++pairs;
+    });
+    benchmark::DoNotOptimize(pairs);
+  }
+  state.counters["pairs"] = static_cast<double>(pairs);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK(BM_JoinBySweep)->RangeMultiplier(8)->Range(1 << 12, 1 << 18)->Unit(benchmark::kMillisecond);
+
+namespace
+{
+  /**
+   * @brief An input iterator over the points [i, i] for i = first, first + 1, ..., generated on the fly.
+   *
+   * Each step records the live heap bytes, so a join reading it reports the
+   * peak memory it held without the input itself taking any.
+   */
+  class PointStream
+  {
+    public:
+      typedef Interval<int> value_type;
+      typedef Interval<int> reference;
+      typedef const Interval<int>* pointer;
+      typedef std::ptrdiff_t difference_type;
+      typedef std::input_iterator_tag iterator_category;
+
+      PointStream(int next, size_t* peak) : next(next), peak(peak) {}
+
+      Interval<int> operator*() const { return Interval<int>(next, next); }
+
+      PointStream& operator++()
+      {
+        ++next;
+        *peak = std::max(*peak, AllocatedBytes());
+        return *this;
+      }
+
+      bool operator==(const PointStream& other) const { return next == other.next; }
+      bool operator!=(const PointStream& other) const { return next != other.next; }
+
+    private:
+      int next; ///< The point this iterator stands on.
+      size_t* peak; ///< The highest live byte count seen so far.
+  };
+}
+
+/**
+ * @brief Streams state.range(0) disjoint points as A against one B interval past all of them.
+ *
+ * At most one A interval is ever active, so the peakBytes counter must stay
+ * flat as the stream grows; it would grow with the stream if the active set
+ * of the side being read were never pruned.
+ */
+static void BM_JoinDisjointStream(benchmark::State& state)
+{
+  const int count = static_cast<int>(state.range(0));
+  const std::vector<Interval<int> > right(1, Interval<int>(2 * count, 2 * count));
+
+  size_t peak = 0;
+  for(auto _ : state)
+  {
+    size_t pairs = 0;
+    const size_t before = AllocatedBytes();
+    peak = before;
+    OverlapJoin(PointStream(0, &peak), PointStream(count, &peak), right.begin(), right.end(),
+      [&pairs](const Interval<int>&, const Interval<int>&)
+      {
+        ++pairs;
+      });
+    peak -= before;
+    benchmark::DoNotOptimize(pairs);
+  }
+  state.counters["peakBytes"] = static_cast<double>(peak);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK(BM_JoinDisjointStream)->RangeMultiplier(16)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,310 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <future>
+#include <vector>
+
+#include "../IntervalTree.h"
+#include "../PooledIntervalTree.h"
+#include "AllocationCounter.h"
+#include "BenchmarkData.h"
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Measures build time and heap bytes per interval for the std::shared_ptr node layout.
+ */
+static void BM_BuildSharedPtrTree(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  size_t bytes = 0;
+
+  for(auto _ : state)
+  {
+    size_t before = AllocatedBytes();
+    IntervalTree<int> tree;
+    for(const Interval<int>& i : intervals)
+    {
+      tree.Insert(i);
+    }
+    bytes = AllocatedBytes() - before;
+    benchmark::DoNotOptimize(tree.Size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+  state.counters["bytes_per_interval"] = static_cast<double>(bytes) / count;
+}
+BENCHMARK(BM_BuildSharedPtrTree)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Measures build time and heap bytes per interval for the pooled 32-bit index layout.
+ */
+static void BM_BuildPooledTree(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  size_t bytes = 0;
+
+  for(auto _ : state)
+  {
+    size_t before = AllocatedBytes();
+    PooledIntervalTree<int> tree;
+    for(const Interval<int>& i : intervals)
+    {
+      tree.Insert(i);
+    }
+    bytes = AllocatedBytes() - before;
+    benchmark::DoNotOptimize(tree.Size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+  state.counters["bytes_per_interval"] = static_cast<double>(bytes) / count;
+}
+BENCHMARK(BM_BuildPooledTree)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Measures the pooled layout when the pool is reserved up front, so the slab never regrows.
+ */
+static void BM_BuildPooledTreeReserved(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  size_t bytes = 0;
+
+  for(auto _ : state)
+  {
+    size_t before = AllocatedBytes();
+    PooledIntervalTree<int> tree;
+    tree.Reserve(count);
+    for(const Interval<int>& i : intervals)
+    {
+      tree.Insert(i);
+    }
+    bytes = AllocatedBytes() - before;
+    benchmark::DoNotOptimize(tree.Size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+  state.counters["bytes_per_interval"] = static_cast<double>(bytes) / count;
+}
+BENCHMARK(BM_BuildPooledTreeReserved)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Measures heap bytes per interval when every interval carries a std::shared_ptr payload.
+ */
+static void BM_BuildSharedPtrPayload(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  size_t bytes = 0;
+
+  for(auto _ : state)
+  {
+    size_t before = AllocatedBytes();
+    IntervalTree<int> tree;
+    for(const Interval<int>& i : intervals)
+    {
+      tree.Insert(i, std::make_shared<int>(i.low));
+    }
+    bytes = AllocatedBytes() - before;
+    benchmark::DoNotOptimize(tree.Size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+  state.counters["bytes_per_interval"] = static_cast<double>(bytes) / count;
+}
+BENCHMARK(BM_BuildSharedPtrPayload)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Measures the same payloads stored inline in the node with IntervalTree<int, int>.
+ */
+static void BM_BuildInlinePayload(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  size_t bytes = 0;
+
+  for(auto _ : state)
+  {
+    size_t before = AllocatedBytes();
+    IntervalTree<int, int> tree;
+    for(const Interval<int>& i : intervals)
+    {
+      tree.Insert(i, i.low);
+    }
+    bytes = AllocatedBytes() - before;
+    benchmark::DoNotOptimize(tree.Size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+  state.counters["bytes_per_interval"] = static_cast<double>(bytes) / count;
+}
+BENCHMARK(BM_BuildInlinePayload)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+static const size_t PoolQueries = 1 << 12; ///< Distinct queries per run, so the hot set does not fit in cache either.
+
+/**
+ * @brief Contains latency on the std::shared_ptr node layout, for trees that fit in the LLC and trees that do not.
+ */
+static void BM_ContainsSharedPtrTree(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  IntervalTree<int> tree;
+  for(const Interval<int>& i : intervals)
+  {
+    tree.Insert(i); // Like the pooled tree, so both have nodes scattered in insertion order
+  }
+  const std::vector<Interval<int> > queries = RandomQueries(PoolQueries, count, 0, 3);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(tree.Contains(queries[next++ % queries.size()].low));
+  }
+  state.counters["node_bytes"] = static_cast<double>(sizeof(Node<int, std::shared_ptr<int> >));
+}
+BENCHMARK(BM_ContainsSharedPtrTree)->Arg(1 << 20)->Arg(1 << 23);
+
+/**
+ * @brief Contains latency on the pooled layout, whose hot search fields sit apart from the payloads.
+ */
+static void BM_ContainsPooledTree(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  PooledIntervalTree<int> tree;
+  tree.Reserve(count);
+  for(const Interval<int>& i : intervals)
+  {
+    tree.Insert(i);
+  }
+  const std::vector<Interval<int> > queries = RandomQueries(PoolQueries, count, 0, 3);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(tree.Contains(queries[next++ % queries.size()].low));
+  }
+  state.counters["node_bytes"] = static_cast<double>(sizeof(PooledNode<int>));
+}
+BENCHMARK(BM_ContainsPooledTree)->Arg(1 << 20)->Arg(1 << 23);
+
+/**
+ * @brief Overlapping latency on the std::shared_ptr node layout, which also copies each hit's payload.
+ */
+static void BM_OverlappingSharedPtrTree(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  IntervalTree<int> tree;
+  for(const Interval<int>& i : intervals)
+  {
+    tree.Insert(i); // Like the pooled tree, so both have nodes scattered in insertion order
+  }
+  const std::vector<Interval<int> > queries = RandomQueries(PoolQueries, count, 1000, 3);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& q = queries[next++ % queries.size()];
+    benchmark::DoNotOptimize(tree.Overlapping(q.low, q.high).size());
+  }
+}
+BENCHMARK(BM_OverlappingSharedPtrTree)->Arg(1 << 20)->Arg(1 << 23);
+
+/**
+ * @brief Overlapping latency on the pooled layout.
+ */
+static void BM_OverlappingPooledTree(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  PooledIntervalTree<int> tree;
+  tree.Reserve(count);
+  for(const Interval<int>& i : intervals)
+  {
+    tree.Insert(i);
+  }
+  const std::vector<Interval<int> > queries = RandomQueries(PoolQueries, count, 1000, 3);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& q = queries[next++ % queries.size()];
+    benchmark::DoNotOptimize(tree.Overlapping(q.low, q.high).size());
+  }
+}
+BENCHMARK(BM_OverlappingPooledTree)->Arg(1 << 20)->Arg(1 << 23);
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Time the calling thread spends tearing down a tree with Clear, or only handing it to ClearAsync when the argument is 1.
+ *
+ * The iteration count is fixed because each one rebuilds the tree untimed, which would dwarf an asynchronous clear.
+ */
+static void BM_ClearSharedPtrTree(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const bool async = state.range(1) != 0;
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+
+  for(auto _ : state)
+  {
+    state.PauseTiming();
+    IntervalTree<int> tree;
+    for(const Interval<int>& i : intervals)
+    {
+      tree.Insert(i, std::make_shared<int>(i.low));
+    }
+    state.ResumeTiming();
+
+    if(async)
+    {
+      std::future<void> done = tree.ClearAsync();
+      state.PauseTiming();
+      done.wait(); // Not charged to the caller, which only waits if it drops the future early
+      state.ResumeTiming();
+    }
+    else
+    {
+      tree.Clear();
+    }
+    benchmark::DoNotOptimize(tree.Size());
+  }
+}
+BENCHMARK(BM_ClearSharedPtrTree)->ArgsProduct({ { 1 << 18, 1 << 20 }, { 0, 1 } })->ArgNames({ "n", "async" })->Iterations(8)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief The same teardown for the pooled layout, where Clear frees the slab and the payload array without a walk.
+ */
+static void BM_ClearPooledTree(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const bool async = state.range(1) != 0;
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+
+  for(auto _ : state)
+  {
+    state.PauseTiming();
+    PooledIntervalTree<int> tree;
+    tree.Reserve(count);
+    for(const Interval<int>& i : intervals)
+    {
+      tree.Insert(i, std::make_shared<int>(i.low));
+    }
+    state.ResumeTiming();
+
+    if(async)
+    {
+      std::future<void> done = tree.ClearAsync();
+      state.PauseTiming();
+      done.wait();
+      state.ResumeTiming();
+    }
+    else
+    {
+      tree.Clear();
+    }
+    benchmark::DoNotOptimize(tree.Size());
+  }
+}
+BENCHMARK(BM_ClearPooledTree)->ArgsProduct({ { 1 << 18, 1 << 20 }, { 0, 1 } })->ArgNames({ "n", "async" })->Iterations(8)->Unit(benchmark::kMillisecond);
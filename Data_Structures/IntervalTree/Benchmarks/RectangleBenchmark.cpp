@@ -0,0 +1,97 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "../IntervalTree.h"
+#include "../RectangleIndex.h"
+#include "BenchmarkData.h"
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Generates rectangles whose extents in each dimension follow RandomIntervals, tagged with their position.
+ */
+static std::vector<std::pair<Rectangle<int>, int> > RandomRectangles(size_t count)
+{
+  const std::vector<Interval<int> > xs = RandomIntervals(count, 42);
+  const std::vector<Interval<int> > ys = RandomIntervals(count, 43);
+  std::vector<std::pair<Rectangle<int>, int> > rectangles;
+  rectangles.reserve(count);
+  for(size_t n = 0; n < count; ++n)
+  {
+    rectangles.push_back(std::make_pair(Rectangle<int>(xs[n], ys[n]), static_cast<int>(n)));
+  }
+  return rectangles;
+}
+
+/**
+ * @brief Baseline: one IntervalTree per dimension, with the two Overlapping() results intersected by id.
+ */
+static void BM_RectanglesByTwoTrees(benchmark::State& state)
+{
+  const size_t size = static_cast<size_t>(state.range(0));
+  const std::vector<std::pair<Rectangle<int>, int> > rectangles = RandomRectangles(size);
+  std::vector<std::pair<Interval<int>, int> > xs;
+  std::vector<std::pair<Interval<int>, int> > ys;
+  for(size_t n = 0; n < size; ++n)
+  {
+    xs.push_back(std::make_pair(rectangles[n].first.x, rectangles[n].second));
+    ys.push_back(std::make_pair(rectangles[n].first.y, rectangles[n].second));
+  }
+  const IntervalTree<int, int> xTree(xs.begin(), xs.end());
+  const IntervalTree<int, int> yTree(ys.begin(), ys.end());
+  const int width = static_cast<int>(state.range(1));
+  const std::vector<Interval<int> > xQueries = RandomQueries(1024, size, width, 3);
+  const std::vector<Interval<int> > yQueries = RandomQueries(1024, size, width, 4);
+
+  size_t next = 0;
+  size_t hits = 0;
+  for(auto _ : state)
+  {
+    const size_t q = next++ % xQueries.size();
+    std::vector<int> ids;
+    xTree.ForEachOverlapping(xQueries[q].low, xQueries[q].high, [&ids](const Interval<int>&, const int& id)
+    {
+      ids.push_back(id);
+    });
+    std::sort(ids.begin(), ids.end());
+    size_t found = 0;
+    yTree.ForEachOverlapping(yQueries[q].low, yQueries[q].high, [&ids, &found](const Interval<int>&, const int& id)
+    {
+      found += std::binary_search(ids.begin(), ids.end(), id);
+    });
+    benchmark::DoNotOptimize(found);
+    hits += found;
+  }
+  state.counters["hits"] = benchmark::Counter(static_cast<double>(hits), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_RectanglesByTwoTrees)->ArgsProduct({ { 1 << 16, 1 << 20 }, { 0, 1 << 10, 1 << 16 } });
+
+/**
+ * @brief RectangleIndex: both dimensions pruned in one descent.
+ */
+static void BM_RectanglesByIndex(benchmark::State& state)
+{
+  const size_t size = static_cast<size_t>(state.range(0));
+  const std::vector<std::pair<Rectangle<int>, int> > rectangles = RandomRectangles(size);
+  const RectangleIndex<int, int> index(rectangles.begin(), rectangles.end());
+  const int width = static_cast<int>(state.range(1));
+  const std::vector<Interval<int> > xQueries = RandomQueries(1024, size, width, 3);
+  const std::vector<Interval<int> > yQueries = RandomQueries(1024, size, width, 4);
+
+  size_t next = 0;
+  size_t hits = 0;
+  for(auto _ : state)
+  {
+    const size_t q = next++ % xQueries.size();
+    size_t found = index.CountOverlapping(xQueries[q], yQueries[q]);
+    benchmark::DoNotOptimize(found);
+    hits += found;
+  }
+  state.counters["hits"] = benchmark::Counter(static_cast<double>(hits), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_RectanglesByIndex)->ArgsProduct({ { 1 << 16, 1 << 20 }, { 0, 1 << 10, 1 << 16 } });
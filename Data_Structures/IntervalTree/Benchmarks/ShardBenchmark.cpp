@@ -0,0 +1,80 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "../ShardedIntervalTree.h"
+#include "BenchmarkData.h"
+
+//---------------------------------------------------------------------------
+
+static const size_t ShardWrites = 1 << 20; ///< Keys span 10 * ShardWrites, like RandomIntervals(ShardWrites, ...).
+
+static ShardedIntervalTree<int, int>* SharedShards = nullptr; ///< Set up and torn down by thread 0.
+
+/**
+ * @brief Cuts the key space of RandomIntervals(ShardWrites, ...) into equal shards.
+ */
+static std::vector<int> EvenBoundaries(size_t shards)
+{
+  std::vector<int> boundaries;
+  for(size_t k = 1; k < shards; ++k)
+  {
+    boundaries.push_back(static_cast<int>(k * ShardWrites * 10 / shards));
+  }
+  return boundaries;
+}
+
+/**
+ * @brief Every thread inserts random intervals into one shared tree with state.range(0) shards.
+ *
+ * A single shard is one IntervalTree behind one mutex. items_per_second should
+ * grow with the thread count only when there are shards to spread over.
+ */
+static void BM_ShardedInsert(benchmark::State& state)
+{
+  if(state.thread_index() == 0)
+  {
+    SharedShards = new ShardedIntervalTree<int, int>(EvenBoundaries(static_cast<size_t>(state.range(0))));
+  }
+  const std::vector<Interval<int> > intervals = RandomIntervals(ShardWrites, 42 + static_cast<unsigned>(state.thread_index()));
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    SharedShards->Insert(intervals[next % intervals.size()], static_cast<int>(next));
+    ++next;
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+
+  if(state.thread_index() == 0)
+  {
+    state.counters["spanning"] = static_cast<double>(SharedShards->Spanning());
+    delete SharedShards;
+    SharedShards = nullptr;
+  }
+}
+BENCHMARK(BM_ShardedInsert)->Arg(1)->Arg(32)->ThreadRange(1, 32)->UseRealTime();
+
+/**
+ * @brief Overlapping queries that fan out to the shards a range reaches, against a tree of 1M intervals.
+ */
+static void BM_ShardedOverlapping(benchmark::State& state)
+{
+  const std::vector<Interval<int> > intervals = RandomIntervals(ShardWrites, 42);
+  ShardedIntervalTree<int, int> tree(EvenBoundaries(static_cast<size_t>(state.range(0))));
+  for(size_t n = 0; n < intervals.size(); ++n)
+  {
+    tree.Insert(intervals[n], static_cast<int>(n));
+  }
+  const std::vector<Interval<int> > queries = RandomQueries(1024, ShardWrites, static_cast<int>(state.range(1)), 3);
+
+  size_t next = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& q = queries[next++ % queries.size()];
+    benchmark::DoNotOptimize(tree.CountOverlapping(q.low, q.high));
+  }
+}
+BENCHMARK(BM_ShardedOverlapping)->ArgsProduct({ { 1, 32 }, { 0, 1 << 10, 1 << 16 } });
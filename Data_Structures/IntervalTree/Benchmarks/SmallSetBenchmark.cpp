@@ -0,0 +1,82 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <limits>
+#include <vector>
+
+#include "../IntervalTree.h"
+#include "../SmallIntervalSet.h"
+#include "BenchmarkData.h"
+
+//---------------------------------------------------------------------------
+
+namespace
+{
+  const size_t QueryCount = 1024; ///< Queries are cycled so every size sees the same mix.
+
+  /**
+   * @brief A SmallIntervalSet that never switches to the tree, so the flat scan is timed at every size.
+   */
+  struct FlatIntervalSet : SmallIntervalSet<int, int>
+  {
+    FlatIntervalSet() : SmallIntervalSet<int, int>(std::numeric_limits<size_t>::max()) {}
+  };
+
+  /**
+   * @brief Fills a tree or a set with the benchmark intervals.
+   */
+  template <typename Set>
+  void Fill(Set& set, const std::vector<Interval<int> >& intervals)
+  {
+    for(size_t n = 0; n < intervals.size(); ++n)
+    {
+      set.Insert(intervals[n], static_cast<int>(n));
+    }
+  }
+}
+
+/**
+ * @brief Measures Contains on a tree or on a set that stays flat at every size, to locate the crossover.
+ */
+template <typename Set>
+static void BM_SmallContains(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  const std::vector<Interval<int> > queries = RandomQueries(QueryCount, count, 0, 7);
+  Set set;
+  Fill(set, intervals);
+
+  size_t q = 0;
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(set.Contains(queries[q++ % QueryCount].low));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK_TEMPLATE(BM_SmallContains, IntervalTree<int, int>)->RangeMultiplier(2)->Range(8, 4096);
+BENCHMARK_TEMPLATE(BM_SmallContains, FlatIntervalSet)->RangeMultiplier(2)->Range(8, 4096);
+
+/**
+ * @brief Measures Overlapping on a tree or on a set that stays flat at every size.
+ */
+template <typename Set>
+static void BM_SmallOverlapping(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  const std::vector<Interval<int> > queries = RandomQueries(QueryCount, count, 20, 7);
+  Set set;
+  Fill(set, intervals);
+
+  size_t q = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& query = queries[q++ % QueryCount];
+    benchmark::DoNotOptimize(set.Overlapping(query.low, query.high));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK_TEMPLATE(BM_SmallOverlapping, IntervalTree<int, int>)->RangeMultiplier(2)->Range(8, 4096);
+BENCHMARK_TEMPLATE(BM_SmallOverlapping, FlatIntervalSet)->RangeMultiplier(2)->Range(8, 4096);
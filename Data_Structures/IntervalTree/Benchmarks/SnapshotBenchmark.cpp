@@ -0,0 +1,85 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "../IntervalTree.h"
+#include "AllocationCounter.h"
+#include "BenchmarkData.h"
+
+//---------------------------------------------------------------------------
+
+static const int SnapshotCount = 100; ///< Versions kept per benchmark iteration.
+static const int ChangesPerSnapshot = 10; ///< Inserts into the live tree between two versions.
+
+/**
+ * @brief Measures the heap bytes of versions taken with Snapshot(), which share unchanged nodes.
+ */
+static void BM_Snapshot(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  const std::vector<Interval<int> > changes = RandomIntervals(SnapshotCount * ChangesPerSnapshot, 7);
+  size_t bytes = 0;
+
+  for(auto _ : state)
+  {
+    state.PauseTiming();
+    IntervalTree<int> tree(intervals.begin(), intervals.end());
+    std::vector<IntervalTree<int> > versions;
+    versions.reserve(SnapshotCount);
+    size_t before = AllocatedBytes();
+    state.ResumeTiming();
+
+    for(int s = 0; s < SnapshotCount; ++s)
+    {
+      versions.push_back(tree.Snapshot());
+      for(int c = 0; c < ChangesPerSnapshot; ++c)
+      {
+        tree.Insert(changes[s * ChangesPerSnapshot + c]);
+      }
+    }
+
+    bytes = AllocatedBytes() - before;
+    benchmark::DoNotOptimize(versions.back().Size());
+  }
+  state.counters["bytes_per_snapshot"] = static_cast<double>(bytes) / SnapshotCount;
+}
+BENCHMARK(BM_Snapshot)->RangeMultiplier(16)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Baseline: the same versions made by rebuilding a full copy of the tree each time.
+ */
+static void BM_DeepCopy(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  const std::vector<Interval<int> > changes = RandomIntervals(SnapshotCount * ChangesPerSnapshot, 7);
+  size_t bytes = 0;
+
+  for(auto _ : state)
+  {
+    state.PauseTiming();
+    IntervalTree<int> tree(intervals.begin(), intervals.end());
+    std::vector<IntervalTree<int> > versions;
+    versions.reserve(SnapshotCount);
+    size_t before = AllocatedBytes();
+    state.ResumeTiming();
+
+    for(int s = 0; s < SnapshotCount; ++s)
+    {
+      const std::vector<std::pair<Interval<int>, std::shared_ptr<int> > > entries = tree.Intervals();
+      versions.push_back(IntervalTree<int>(entries.begin(), entries.end()));
+      for(int c = 0; c < ChangesPerSnapshot; ++c)
+      {
+        tree.Insert(changes[s * ChangesPerSnapshot + c]);
+      }
+    }
+
+    bytes = AllocatedBytes() - before;
+    benchmark::DoNotOptimize(versions.back().Size());
+  }
+  state.counters["bytes_per_snapshot"] = static_cast<double>(bytes) / SnapshotCount;
+}
+BENCHMARK(BM_DeepCopy)->RangeMultiplier(16)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,64 @@
+//---------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "../IntervalTree.h"
+#include "../StaticIntervalIndex.h"
+#include "../WideIntervalIndex.h"
+#include "BenchmarkData.h"
+
+//---------------------------------------------------------------------------
+
+namespace
+{
+  const size_t QueryCount = 4096; ///< Queries are cycled so every size sees the same mix.
+}
+
+/**
+ * @brief Measures point lookups (Contains) on a pointer tree, a static index or a wide index of state.range(0) intervals.
+ */
+template <typename Index>
+static void BM_Contains(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  const std::vector<Interval<int> > queries = RandomQueries(QueryCount, count, 0, 7);
+  const IntervalTree<int> tree(intervals.begin(), intervals.end());
+  const Index index(tree);
+
+  size_t q = 0;
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(index.Contains(queries[q++ % QueryCount].low));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK_TEMPLATE(BM_Contains, IntervalTree<int>)->RangeMultiplier(8)->Range(1 << 12, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Contains, StaticIntervalIndex<int>)->RangeMultiplier(8)->Range(1 << 12, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Contains, WideIntervalIndex<int>)->RangeMultiplier(8)->Range(1 << 12, 1 << 22);
+
+/**
+ * @brief Measures overlap queries on a pointer tree, a static index or a wide index of state.range(0) intervals.
+ */
+template <typename Index>
+static void BM_Overlapping(benchmark::State& state)
+{
+  const size_t count = static_cast<size_t>(state.range(0));
+  const std::vector<Interval<int> > intervals = RandomIntervals(count, 42);
+  const std::vector<Interval<int> > queries = RandomQueries(QueryCount, count, 50, 7);
+  const IntervalTree<int> tree(intervals.begin(), intervals.end());
+  const Index index(tree);
+
+  size_t q = 0;
+  for(auto _ : state)
+  {
+    const Interval<int>& query = queries[q++ % QueryCount];
+    benchmark::DoNotOptimize(index.Overlapping(query.low, query.high));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK_TEMPLATE(BM_Overlapping, IntervalTree<int>)->RangeMultiplier(8)->Range(1 << 12, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Overlapping, StaticIntervalIndex<int>)->RangeMultiplier(8)->Range(1 << 12, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Overlapping, WideIntervalIndex<int>)->RangeMultiplier(8)->Range(1 << 12, 1 << 22);
@@ -0,0 +1,723 @@
+//---------------------------------------------------------------------------
+
+#ifndef ConcurrentIntervalTreeH
+#define ConcurrentIntervalTreeH
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "IntervalTree.h"
+
+/**
+ * @class EpochReclaimer
+ * @brief Epoch-based grace periods that let readers run without ever blocking.
+ *
+ * Readers announce themselves in one of two reader counters selected by the
+ * parity of the global epoch. A writer that wants to free memory it has
+ * unlinked flips the epoch, so new readers move to the other counter, and
+ * waits for the old counter to drain: after that no reader can still hold a
+ * pointer to the unlinked memory. The counters are striped over cache-line
+ * sized slots by thread so readers on different cores do not contend.
+ *
+ * Only writers wait, and Synchronize() must be called by one writer at a time.
+ */
+class EpochReclaimer
+{
+  public:
+    EpochReclaimer() : epoch(0) {} ///< Constructs a reclaimer with no active readers.
+
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+    /**
+     * @class ReadGuard
+     * @brief Keeps everything reachable when the guard was taken alive until it is destroyed.
+     */
+    class ReadGuard
+    {
+      public:
+        explicit ReadGuard(EpochReclaimer& reclaimer) : counter(reclaimer.Enter()) {} ///< Enters a read-side critical section.
+        ~ReadGuard() { counter->fetch_sub(1, std::memory_order_release); } ///< Leaves the read-side critical section.
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+      private:
+        std::atomic<long>* counter; ///< The reader counter this guard incremented.
+    };
+
+    /**
+     * @brief Waits until every reader that entered before the call has left.
+     */
+    void Synchronize()
+    {
+      unsigned old = epoch.fetch_add(1, std::memory_order_seq_cst) & 1u;
+      for(size_t s = 0; s < Stripes; ++s)
+      {
+        while(slots[s].readers[old].load(std::memory_order_acquire) != 0)
+        {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+  private:
+    static const size_t Stripes = 32; ///< The number of reader counter slots.
+
+    /**
+     * @brief A pair of reader counters, one per epoch parity, on its own cache line.
+     */
+    struct alignas(64) Slot
+    {
+      Slot() { readers[0] = 0; readers[1] = 0; }
+      std::atomic<long> readers[2];
+    };
+
+    std::atomic<unsigned> epoch; ///< The global epoch; its parity selects the counter new readers use.
+    Slot slots[Stripes]; ///< The striped reader counters.
+
+    /**
+     * @brief Registers a reader under the current epoch parity.
+     * @return The counter to decrement when the reader leaves.
+     */
+    std::atomic<long>* Enter()
+    {
+      static thread_local size_t stripe = std::hash<std::thread::id>()(std::this_thread::get_id()) % Stripes;
+      for(;;)
+      {
+        unsigned current = epoch.load(std::memory_order_seq_cst);
+        std::atomic<long>* counter = &slots[stripe].readers[current & 1u];
+        counter->fetch_add(1, std::memory_order_seq_cst);
+
+        // If a writer flipped the epoch in between it may already have scanned
+        // this counter, so move to the new parity instead
+        if(epoch.load(std::memory_order_seq_cst) == current)
+        {
+          return counter;
+        }
+        counter->fetch_sub(1, std::memory_order_release);
+      }
+    }
+};
+
+/**
+ * @tparam T The type of data stored in the node.
+ * @struct PersistentNode
+ * @brief An interval tree node that is never modified once it has been published to readers.
+ */
+template <typename T>
+struct PersistentNode
+{
+  Interval<T> interval; ///< The interval associated with this node.
+  T max; ///< The maximum value in the subtree (to help with overlap checks).
+  int height; ///< The height of the subtree rooted at this node (a leaf has height 1).
+  const PersistentNode<T>* left; ///< Pointer to the left child node.
+  const PersistentNode<T>* right; ///< Pointer to the right child node.
+  std::shared_ptr<T> data; ///< Pointer to hold the data of type T.
+  uint64_t version; ///< The write that created the node; only that write may still modify it.
+
+  /**
+   * @brief Constructs a leaf PersistentNode with a given interval and optional data.
+   * @param i The interval for this node.
+   * @param d Optional data associated with the interval.
+   * @param v The write that is creating the node.
+   */
+  PersistentNode(Interval<T> i, std::shared_ptr<T> d, uint64_t v)
+    : interval(i), max(i.high), height(1), left(nullptr), right(nullptr), data(d), version(v) {}
+};
+
+/**
+ * @tparam T The type of data stored in the interval tree.
+ * @class ConcurrentIntervalTree
+ * @brief An AVL interval tree that readers query without locks while writers update it.
+ *
+ * Writers never modify a node readers can see. Insert, Remove and Update copy
+ * the O(log n) nodes on the path they change, rotations included, and publish
+ * the new version with a single atomic store of the root. A query reads
+ * whichever version was published when it started, from start to finish.
+ *
+ * Readers never block: a query takes an EpochReclaimer::ReadGuard, which is a
+ * pair of atomic increments on a per-thread counter. Writers serialize among
+ * themselves on a mutex. Nodes replaced by a write are retired and freed in
+ * batches once a grace period shows no reader can still reach them.
+ *
+ * Visitors passed to ForEachOverlapping run inside the read guard and must
+ * not call the writer methods of the same tree.
+ */
+template <typename T = int>
+class ConcurrentIntervalTree
+{
+  public:
+    ConcurrentIntervalTree() : Root(nullptr), size(0), version(0) {} ///< Constructs an empty ConcurrentIntervalTree.
+
+    /**
+     * @brief Frees every node. No reader or writer may use the tree concurrently.
+     */
+    ~ConcurrentIntervalTree();
+
+    ConcurrentIntervalTree(const ConcurrentIntervalTree&) = delete;
+    ConcurrentIntervalTree& operator=(const ConcurrentIntervalTree&) = delete;
+
+    void Insert(T low, T high, std::shared_ptr<T> data = nullptr); ///< Inserts a new interval into the tree.
+    void Insert(Interval<T> i, std::shared_ptr<T> data = nullptr); ///< Inserts a new interval into the tree.
+
+    /**
+     * @brief Removes an interval whose bounds both match.
+     * @param i The interval to remove.
+     * @return True if an interval was removed, false if none matched.
+     */
+    bool Remove(Interval<T> i);
+
+    /**
+     * @brief Replaces an interval in a single published step.
+     *
+     * Readers see either the old interval or the new one, never both and never neither.
+     *
+     * @param oldInterval The interval to remove.
+     * @param newInterval The interval to insert.
+     * @param newData Optional data for the new interval.
+     * @return True if oldInterval was found; the new interval is inserted either way.
+     */
+    bool Update(Interval<T> oldInterval, Interval<T> newInterval, std::shared_ptr<T> newData = nullptr);
+
+    /**
+     * @brief Finds all intervals that contain a specific value.
+     * @param value The value to check for containment.
+     * @return A vector of intervals that contain the specified value.
+     */
+    std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > Containing(T value) const;
+
+    /**
+     * @brief Finds all intervals that overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return A vector of intervals that overlap with the specified range.
+     */
+    std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > Overlapping(T low, T high) const;
+
+    /**
+     * @brief Calls a visitor for every interval that overlaps with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @param visit The callable invoked as visit(const Interval<T>&, const std::shared_ptr<T>&); returning false stops the query.
+     */
+    template <typename Visitor>
+    void ForEachOverlapping(T low, T high, Visitor visit) const;
+
+    /**
+     * @brief Checks if a specific value is contained within any interval.
+     * @param value The value to check.
+     * @return True if the value is contained in any interval, false otherwise.
+     */
+    bool Contains(T value) const;
+
+    /**
+     * @brief Checks if any intervals overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return True if there are overlapping intervals, false otherwise.
+     */
+    bool Overlaps(T low, T high) const;
+
+    /**
+     * @brief Checks whether the tree is empty.
+     * @return True if the tree is empty, false otherwise.
+     */
+    bool IsEmpty(void) const;
+
+    /**
+     * @brief Gets the number of intervals in the tree.
+     * @return The number of intervals in the tree.
+     */
+    size_t Size() const;
+
+    /**
+     * @brief Waits for a grace period and frees every node retired so far.
+     *
+     * Writers do this on their own once enough nodes are retired; calling it
+     * explicitly bounds memory after a burst of writes.
+     */
+    void Reclaim(void);
+
+  private:
+    typedef PersistentNode<T> NodeType;
+
+    std::atomic<const NodeType*> Root; ///< The root of the most recently published version.
+    std::atomic<size_t> size; ///< The number of intervals in the published version.
+    uint64_t version; ///< The number of writes so far; tags the nodes each write creates.
+    std::vector<const NodeType*> retired; ///< Nodes unlinked by writes, waiting for a grace period.
+    std::mutex writer; ///< Serializes writers.
+    mutable EpochReclaimer epochs; ///< Tracks readers for reclamation.
+
+    static const size_t ReclaimThreshold = 1024; ///< Retired nodes that trigger an automatic Reclaim.
+
+    /**
+     * @brief Returns a node the current write may modify: the node itself if the write created it, else a copy.
+     */
+    NodeType* Mutable(const NodeType* node);
+
+    /**
+     * @brief Helper function to insert an interval along a copied path.
+     */
+    const NodeType* Insert(const NodeType* node, const Interval<T>& i, const std::shared_ptr<T>& data);
+
+    /**
+     * @brief Helper function to remove an interval along a copied path.
+     */
+    const NodeType* Remove(const NodeType* node, const Interval<T>& i, bool& removed);
+
+    /**
+     * @brief Removes the leftmost node of the subtree.
+     */
+    const NodeType* RemoveMin(const NodeType* node);
+
+    /**
+     * @brief Updates the cached maximum value and height of the node from its children.
+     */
+    void UpdateMax(NodeType* node);
+
+    /**
+     * @brief Restores the AVL balance of a node the current write owns.
+     */
+    const NodeType* Rebalance(NodeType* node);
+
+    /**
+     * @brief Performs a right rotation on a node the current write owns.
+     */
+    NodeType* RotateRight(NodeType* node);
+
+    /**
+     * @brief Performs a left rotation on a node the current write owns.
+     */
+    NodeType* RotateLeft(NodeType* node);
+
+    /**
+     * @brief Publishes the new root, then frees retired nodes if enough have piled up.
+     */
+    void Publish(const NodeType* root, size_t newSize);
+
+    /**
+     * @brief Visits overlapping intervals with a given range.
+     */
+    template <typename Visitor>
+    void FindOverlapping(const NodeType* node, T low, T high, Visitor& visit) const;
+
+    static int Height(const NodeType* node) { return node ? node->height : 0; } ///< Returns the cached height of the subtree.
+};
+
+
+template <typename T>
+ConcurrentIntervalTree<T>::~ConcurrentIntervalTree()
+{
+  // Retired nodes are no longer reachable from the root, so nothing is freed twice
+  for(size_t r = 0; r < retired.size(); ++r)
+  {
+    delete retired[r];
+  }
+
+  std::vector<const NodeType*> stack;
+  if(const NodeType* root = Root.load())
+  {
+    stack.push_back(root);
+  }
+  while(!stack.empty())
+  {
+    const NodeType* node = stack.back();
+    stack.pop_back();
+    if(node->left)
+    {
+      stack.push_back(node->left);
+    }
+    if(node->right)
+    {
+      stack.push_back(node->right);
+    }
+    delete node;
+  }
+}
+
+template <typename T>
+void ConcurrentIntervalTree<T>::Insert(T low, T high, std::shared_ptr<T> data)
+{
+  Interval<T> i(low, high);
+  Insert(i, data);
+}
+
+template <typename T>
+void ConcurrentIntervalTree<T>::Insert(Interval<T> i, std::shared_ptr<T> data)
+{
+  if(i.low > i.high)
+  {
+    throw std::invalid_argument("Invalid interval: low must be less than or equal to high.");
+  }
+  std::lock_guard<std::mutex> lock(writer);
+  ++version;
+  Publish(Insert(Root.load(std::memory_order_relaxed), i, data), size.load(std::memory_order_relaxed) + 1);
+}
+
+template <typename T>
+bool ConcurrentIntervalTree<T>::Remove(Interval<T> i)
+{
+  std::lock_guard<std::mutex> lock(writer);
+  ++version;
+  bool removed = false;
+  const NodeType* root = Remove(Root.load(std::memory_order_relaxed), i, removed);
+  if(removed)
+  {
+    Publish(root, size.load(std::memory_order_relaxed) - 1);
+  }
+  return removed;
+}
+
+template <typename T>
+bool ConcurrentIntervalTree<T>::Update(Interval<T> oldInterval, Interval<T> newInterval, std::shared_ptr<T> newData)
+{
+  if(newInterval.low > newInterval.high)
+  {
+    throw std::invalid_argument("Invalid interval: low must be less than or equal to high.");
+  }
+  std::lock_guard<std::mutex> lock(writer);
+  ++version;
+  bool removed = false;
+  const NodeType* root = Remove(Root.load(std::memory_order_relaxed), oldInterval, removed);
+  root = Insert(root, newInterval, newData); // Same version: nodes copied by the removal are reused
+  Publish(root, size.load(std::memory_order_relaxed) + (removed ? 0 : 1));
+  return removed;
+}
+
+template <typename T>
+std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > ConcurrentIntervalTree<T>::Containing(T value) const
+{
+  return Overlapping(value, value);
+}
+
+template <typename T>
+std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > ConcurrentIntervalTree<T>::Overlapping(T low, T high) const
+{
+  std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > result;
+  ForEachOverlapping(low, high, [&result](const Interval<T>& i, const std::shared_ptr<T>& data)
+  {
+    result.emplace_back(i, data);
+  });
+  return result;
+}
+
+template <typename T>
+template <typename Visitor>
+void ConcurrentIntervalTree<T>::ForEachOverlapping(T low, T high, Visitor visit) const
+{
+  EpochReclaimer::ReadGuard guard(epochs);
+  FindOverlapping(Root.load(std::memory_order_acquire), low, high, visit);
+}
+
+template <typename T>
+bool ConcurrentIntervalTree<T>::Contains(T value) const
+{
+  return Overlaps(value, value);
+}
+
+template <typename T>
+bool ConcurrentIntervalTree<T>::Overlaps(T low, T high) const
+{
+  EpochReclaimer::ReadGuard guard(epochs);
+  const NodeType* node = Root.load(std::memory_order_acquire);
+  while(node && node->max >= low)
+  {
+    if(node->interval.low <= high && node->interval.high >= low)
+    {
+      return true;
+    }
+
+    // If the left subtree reaches low but holds no overlap, nothing to the right can overlap either
+    if(node->left && node->left->max >= low)
+    {
+      node = node->left;
+    }
+    else if(node->interval.low <= high)
+    {
+      node = node->right;
+    }
+    else
+    {
+      break;
+    }
+  }
+  return false;
+}
+
+template <typename T>
+bool ConcurrentIntervalTree<T>::IsEmpty() const
+{
+  return Root.load(std::memory_order_acquire) == nullptr;
+}
+
+template <typename T>
+size_t ConcurrentIntervalTree<T>::Size() const
+{
+  return size.load(std::memory_order_acquire);
+}
+
+template <typename T>
+void ConcurrentIntervalTree<T>::Reclaim()
+{
+  std::lock_guard<std::mutex> lock(writer);
+  if(retired.empty())
+  {
+    return;
+  }
+  epochs.Synchronize();
+  for(size_t r = 0; r < retired.size(); ++r)
+  {
+    delete retired[r];
+  }
+  retired.clear();
+}
+
+template <typename T>
+typename ConcurrentIntervalTree<T>::NodeType* ConcurrentIntervalTree<T>::Mutable(const NodeType* node)
+{
+  if(node->version == version)
+  {
+    return const_cast<NodeType*>(node); // Created by this write and not yet visible to readers
+  }
+  NodeType* copy = new NodeType(*node);
+  copy->version = version;
+  retired.push_back(node);
+  return copy;
+}
+
+template <typename T>
+const typename ConcurrentIntervalTree<T>::NodeType* ConcurrentIntervalTree<T>::Insert(const NodeType* node,
+  const Interval<T>& i, const std::shared_ptr<T>& data)
+{
+  if(node == nullptr)
+  {
+    return new NodeType(i, data, version);
+  }
+
+  NodeType* copy = Mutable(node);
+  if(i.low < copy->interval.low)
+  {
+    copy->left = Insert(copy->left, i, data);
+  }
+  else
+  {
+    copy->right = Insert(copy->right, i, data);
+  }
+  return Rebalance(copy);
+}
+
+template <typename T>
+const typename ConcurrentIntervalTree<T>::NodeType* ConcurrentIntervalTree<T>::Remove(const NodeType* node,
+  const Interval<T>& i, bool& removed)
+{
+  if(node == nullptr)
+  {
+    return nullptr;
+  }
+
+  // Search first so that a miss copies nothing
+  const NodeType* child;
+  if(i.low < node->interval.low)
+  {
+    child = Remove(node->left, i, removed);
+    if(!removed)
+    {
+      return node;
+    }
+    NodeType* copy = Mutable(node);
+    copy->left = child;
+    return Rebalance(copy);
+  }
+  if(i.low > node->interval.low || i.high != node->interval.high)
+  {
+    // Intervals sharing a low bound can end up on either side after rotations
+    if(i.low == node->interval.low)
+    {
+      child = Remove(node->left, i, removed);
+      if(removed)
+      {
+        NodeType* copy = Mutable(node);
+        copy->left = child;
+        return Rebalance(copy);
+      }
+    }
+    child = Remove(node->right, i, removed);
+    if(!removed)
+    {
+      return node;
+    }
+    NodeType* copy = Mutable(node);
+    copy->right = child;
+    return Rebalance(copy);
+  }
+
+  removed = true;
+  if(node->left == nullptr || node->right == nullptr)
+  {
+    retired.push_back(node);
+    return node->left ? node->left : node->right;
+  }
+
+  // Node with two children: a copy takes over the in-order successor, which is unlinked
+  const NodeType* successor = node->right;
+  while(successor->left)
+  {
+    successor = successor->left;
+  }
+  NodeType* copy = Mutable(node);
+  copy->interval = successor->interval;
+  copy->data = successor->data;
+  copy->right = RemoveMin(copy->right);
+  return Rebalance(copy);
+}
+
+template <typename T>
+const typename ConcurrentIntervalTree<T>::NodeType* ConcurrentIntervalTree<T>::RemoveMin(const NodeType* node)
+{
+  if(node->left == nullptr)
+  {
+    retired.push_back(node);
+    return node->right;
+  }
+  NodeType* copy = Mutable(node);
+  copy->left = RemoveMin(copy->left);
+  return Rebalance(copy);
+}
+
+template <typename T>
+void ConcurrentIntervalTree<T>::UpdateMax(NodeType* node)
+{
+  node->max = node->interval.high;
+  if(node->left)
+  {
+    node->max = std::max(node->max, node->left->max);
+  }
+  if(node->right)
+  {
+    node->max = std::max(node->max, node->right->max);
+  }
+  node->height = 1 + std::max(Height(node->left), Height(node->right));
+}
+
+template <typename T>
+const typename ConcurrentIntervalTree<T>::NodeType* ConcurrentIntervalTree<T>::Rebalance(NodeType* node)
+{
+  UpdateMax(node);
+
+  int balance = Height(node->left) - Height(node->right);
+  if(balance > 1)
+  {
+    const NodeType* left = node->left;
+    if(Height(left->left) < Height(left->right))
+    {
+      node->left = RotateLeft(Mutable(left));
+    }
+    return RotateRight(node);
+  }
+  if(balance < -1)
+  {
+    const NodeType* right = node->right;
+    if(Height(right->right) < Height(right->left))
+    {
+      node->right = RotateRight(Mutable(right));
+    }
+    return RotateLeft(node);
+  }
+  return node;
+}
+
+template <typename T>
+typename ConcurrentIntervalTree<T>::NodeType* ConcurrentIntervalTree<T>::RotateRight(NodeType* node)
+{
+  NodeType* newRoot = Mutable(node->left);
+  node->left = newRoot->right;
+  newRoot->right = node;
+
+  // Update the max value of the rotated nodes
+  UpdateMax(node);
+  UpdateMax(newRoot);
+
+  return newRoot; // New root of the subtree
+}
+
+template <typename T>
+typename ConcurrentIntervalTree<T>::NodeType* ConcurrentIntervalTree<T>::RotateLeft(NodeType* node)
+{
+  NodeType* newRoot = Mutable(node->right);
+  node->right = newRoot->left;
+  newRoot->left = node;
+
+  // Update the max value of the rotated nodes
+  UpdateMax(node);
+  UpdateMax(newRoot);
+
+  return newRoot; // New root of the subtree
+}
+
+template <typename T>
+void ConcurrentIntervalTree<T>::Publish(const NodeType* root, size_t newSize)
+{
+  // The release store makes the fully built copies visible before the root that links them
+  Root.store(root, std::memory_order_release);
+  size.store(newSize, std::memory_order_release);
+
+  if(retired.size() >= ReclaimThreshold)
+  {
+    epochs.Synchronize();
+    for(size_t r = 0; r < retired.size(); ++r)
+    {
+      delete retired[r];
+    }
+    retired.clear();
+  }
+}
+
+template <typename T>
+template <typename Visitor>
+void ConcurrentIntervalTree<T>::FindOverlapping(const NodeType* node, T low, T high, Visitor& visit) const
+{
+  IntervalTreeDetail::NodeStack<const NodeType*> stack(Height(node));
+  if(node)
+  {
+    stack.Push(node);
+  }
+
+  while(!stack.IsEmpty())
+  {
+    node = stack.Pop();
+    if(node->max < low)
+    {
+      continue; // Nothing in this subtree reaches the query
+    }
+
+    if(node->interval.low <= high)
+    {
+      if(node->interval.high >= low && !IntervalTreeDetail::Visit(visit, node->interval, node->data))
+      {
+        return;
+      }
+
+      // Lows in the right subtree are at least node->interval.low, so it can only overlap if that is still <= high
+      if(node->right)
+      {
+        stack.Push(node->right);
+      }
+    }
+
+    // Pushed last so the left subtree is visited first
+    if(node->left)
+    {
+      stack.Push(node->left);
+    }
+  }
+}
+#endif
@@ -0,0 +1,290 @@
+//---------------------------------------------------------------------------
+
+#ifndef DisjointIntervalSetH
+#define DisjointIntervalSetH
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "IntervalTree.h"
+
+/**
+ * @tparam T The type of the interval bounds; must be arithmetic.
+ * @class DisjointIntervalSet
+ * @brief A set of values kept as the union of its intervals, stored as disjoint runs in an IntervalTree.
+ *
+ * Insert merges the new interval with every run it overlaps or touches, and
+ * Remove cuts the removed range out of the runs, splitting a run that it
+ * falls inside of. The tree therefore holds one node per maximal run, however
+ * many overlapping intervals were inserted, and a query reports each covered
+ * stretch once.
+ *
+ * Runs are closed intervals. For integral keys, [a, b] and [b + 1, c] touch
+ * and are merged. For floating-point keys, runs touch when no representable
+ * value lies between them, and removing [low, high] leaves the neighbours of
+ * low and high that std::nextafter gives.
+ */
+template <typename T = int>
+class DisjointIntervalSet
+{
+  static_assert(std::is_arithmetic<T>::value, "Runs are merged and split by stepping to the next key, which needs arithmetic keys.");
+
+  public:
+    /**
+     * @brief Adds every value in [low, high] to the set.
+     * @param low The lower bound of the interval.
+     * @param high The upper bound of the interval.
+     * @throws std::invalid_argument if low > high.
+     */
+    void Insert(T low, T high);
+    void Insert(Interval<T> i); ///< Adds every value in i to the set.
+
+    /**
+     * @brief Takes every value in [low, high] out of the set.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return True if any value was in the set, false if the range was already free.
+     * @throws std::invalid_argument if low > high.
+     */
+    bool Remove(T low, T high);
+    bool Remove(Interval<T> i); ///< Takes every value in i out of the set.
+
+    /**
+     * @brief Checks if a specific value is in the set.
+     * @param value The value to check.
+     * @return True if a run contains the value, false otherwise.
+     */
+    bool Contains(T value) const;
+
+    /**
+     * @brief Checks if any value of a range is in the set.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return True if a run overlaps the range, false otherwise.
+     */
+    bool Overlaps(T low, T high) const;
+
+    /**
+     * @brief Checks if every value of a range is in the set.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return True if a single run spans the whole range, false otherwise.
+     */
+    bool Covers(T low, T high) const;
+
+    /**
+     * @brief Finds the runs that overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return The overlapping runs in ascending order.
+     */
+    std::vector<Interval<T> > Overlapping(T low, T high) const;
+
+    /**
+     * @brief Gets every run of the set.
+     * @return The runs in ascending order.
+     */
+    std::vector<Interval<T> > Runs() const;
+
+    void Clear(void); ///< Removes every run.
+
+    /**
+     * @brief Checks whether the set is empty.
+     * @return True if the set holds no values, false otherwise.
+     */
+    bool IsEmpty(void) const;
+
+    /**
+     * @brief Gets the number of disjoint runs, which is also the number of nodes in the tree.
+     * @return The number of runs.
+     */
+    size_t Size() const;
+
+  private:
+    struct Unit {}; ///< The runs carry no payload.
+
+    IntervalTree<T, Unit> tree; ///< The runs, none of which overlap or touch another.
+
+    /**
+     * @brief Gets the greatest key below value, or value itself if there is none.
+     */
+    static T Before(T value)
+    {
+      return Step(value, std::numeric_limits<T>::lowest(), std::is_integral<T>());
+    }
+
+    /**
+     * @brief Gets the smallest key above value, or value itself if there is none.
+     */
+    static T After(T value)
+    {
+      return Step(value, std::numeric_limits<T>::max(), std::is_integral<T>());
+    }
+
+    static T Step(T value, T limit, std::true_type)
+    {
+      return value == limit ? value : limit < value ? T(value - 1) : T(value + 1);
+    }
+
+    static T Step(T value, T limit, std::false_type)
+    {
+      return value == limit ? value : std::nextafter(value, limit);
+    }
+
+    /**
+     * @brief Takes the runs that overlap [low, high] out of the tree.
+     * @return The runs removed, in ascending order.
+     */
+    std::vector<Interval<T> > Extract(T low, T high);
+};
+
+
+template <typename T>
+void DisjointIntervalSet<T>::Insert(T low, T high)
+{
+  Insert(Interval<T>(low, high));
+}
+
+template <typename T>
+void DisjointIntervalSet<T>::Insert(Interval<T> i)
+{
+  if(i.low > i.high)
+  {
+    throw std::invalid_argument("Invalid interval: low must be less than or equal to high.");
+  }
+
+  // Runs that end on the key just before low or start on the key just after high touch i
+  std::vector<Interval<T> > runs = Overlapping(Before(i.low), After(i.high));
+  if(runs.size() == 1 && runs.front().low <= i.low && runs.front().high >= i.high)
+  {
+    return; // Already covered, which is common when the same ranges are reserved again
+  }
+  for(size_t n = 0; n < runs.size(); ++n)
+  {
+    tree.Remove(runs[n]);
+  }
+  if(!runs.empty())
+  {
+    i.low = std::min(i.low, runs.front().low);
+    i.high = std::max(i.high, runs.back().high);
+  }
+  tree.Insert(i, Unit());
+}
+
+template <typename T>
+bool DisjointIntervalSet<T>::Remove(T low, T high)
+{
+  return Remove(Interval<T>(low, high));
+}
+
+template <typename T>
+bool DisjointIntervalSet<T>::Remove(Interval<T> i)
+{
+  if(i.low > i.high)
+  {
+    throw std::invalid_argument("Invalid interval: low must be less than or equal to high.");
+  }
+
+  std::vector<Interval<T> > runs = Extract(i.low, i.high);
+  if(runs.empty())
+  {
+    return false;
+  }
+
+  // Only the first and last run can stick out of the range; what sticks out stays
+  if(runs.front().low < i.low)
+  {
+    tree.Insert(Interval<T>(runs.front().low, Before(i.low)), Unit());
+  }
+  if(runs.back().high > i.high)
+  {
+    tree.Insert(Interval<T>(After(i.high), runs.back().high), Unit());
+  }
+  return true;
+}
+
+template <typename T>
+bool DisjointIntervalSet<T>::Contains(T value) const
+{
+  return tree.Contains(value);
+}
+
+template <typename T>
+bool DisjointIntervalSet<T>::Overlaps(T low, T high) const
+{
+  return tree.Overlaps(low, high);
+}
+
+template <typename T>
+bool DisjointIntervalSet<T>::Covers(T low, T high) const
+{
+  if(low > high)
+  {
+    return true;
+  }
+  bool covered = false;
+  auto check = [&covered, high](const Interval<T>& run, const Unit&)
+  {
+    covered = run.high >= high;
+    return false; // Runs are disjoint, so at most one contains low
+  };
+  tree.ForEachContaining(low, check);
+  return covered;
+}
+
+template <typename T>
+std::vector<Interval<T> > DisjointIntervalSet<T>::Overlapping(T low, T high) const
+{
+  std::vector<Interval<T> > result;
+  for(const Node<T, Unit>& node : tree.OverlapRange(low, high))
+  {
+    result.push_back(node.interval);
+  }
+  return result;
+}
+
+template <typename T>
+std::vector<Interval<T> > DisjointIntervalSet<T>::Runs() const
+{
+  std::vector<Interval<T> > result;
+  result.reserve(tree.Size());
+  for(const Node<T, Unit>& node : tree)
+  {
+    result.push_back(node.interval);
+  }
+  return result;
+}
+
+template <typename T>
+void DisjointIntervalSet<T>::Clear()
+{
+  tree.Clear();
+}
+
+template <typename T>
+bool DisjointIntervalSet<T>::IsEmpty() const
+{
+  return tree.IsEmpty();
+}
+
+template <typename T>
+size_t DisjointIntervalSet<T>::Size() const
+{
+  return tree.Size();
+}
+
+template <typename T>
+std::vector<Interval<T> > DisjointIntervalSet<T>::Extract(T low, T high)
+{
+  std::vector<Interval<T> > runs = Overlapping(low, high);
+  for(size_t n = 0; n < runs.size(); ++n)
+  {
+    tree.Remove(runs[n]);
+  }
+  return runs;
+}
+#endif
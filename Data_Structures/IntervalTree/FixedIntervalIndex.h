@@ -0,0 +1,291 @@
+//---------------------------------------------------------------------------
+
+#ifndef FixedIntervalIndexH
+#define FixedIntervalIndexH
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "IntervalTree.h"
+
+namespace IntervalTreeDetail
+{
+  /**
+   * @brief A compile-time list of indices, as std::index_sequence provides from C++14 on.
+   */
+  template <size_t... I>
+  struct IndexSequence
+  {
+  };
+
+  /**
+   * @brief Builds IndexSequence<0, ..., N - 1> as its Type member.
+   */
+  template <size_t N, size_t... I>
+  struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, I...>
+  {
+  };
+
+  template <size_t... I>
+  struct MakeIndexSequence<0, I...>
+  {
+    typedef IndexSequence<I...> Type;
+  };
+
+  /**
+   * @brief Gets the number of bits needed to write n, which is floor(log2 n) + 1 for n > 0.
+   */
+  constexpr size_t BitWidth(size_t n)
+  {
+    return n == 0 ? 0 : 1 + BitWidth(n / 2);
+  }
+}
+
+/**
+ * @tparam T The type of the interval bounds.
+ * @tparam V The type of the value stored with each interval.
+ * @tparam N The number of intervals.
+ * @class FixedIntervalIndex
+ * @brief An interval index over a table known at compile time, such as port or opcode ranges.
+ *
+ * The table must be sorted by low. The constructor is constexpr and stores
+ * the lows, the highs, the running maximum of the highs and the values in
+ * flat arrays, so a constexpr table gives an index that lives in read-only
+ * data and can be queried in static_assert. An unsorted table or an interval
+ * with low > high stops compilation, or throws std::invalid_argument when the
+ * index is built at run time.
+ *
+ * Contains and Overlaps are a binary search for the last low at or below the
+ * query, unrolled over the compile-time size into ceil(log2 N) conditional
+ * moves, followed by one compare against the running maximum. Find then
+ * steps back over the trailing intervals that end below the key, a power of
+ * two at a time, using the highest high of every aligned run of 2^j entries:
+ * floor(log2 N) + 1 more conditional moves. Both sequences are the same for
+ * every key. The run maxima take N (floor(log2 N) + 1) keys. Building at
+ * compile time takes O(N^2) constexpr steps, which suits tables of a few
+ * hundred entries.
+ *
+ * @code
+ * constexpr std::pair<Interval<int>, int> ports[] = { { Interval<int>(0, 1023), 0 }, { Interval<int>(1024, 49151), 1 } };
+ * constexpr FixedIntervalIndex<int, int, 2> index(ports);
+ * static_assert(index.Find(80, -1) == 0, "well-known port");
+ * @endcode
+ */
+template <typename T, typename V, size_t N>
+class FixedIntervalIndex
+{
+  static_assert(N > 0, "A FixedIntervalIndex needs at least one interval.");
+
+  public:
+    typedef std::pair<Interval<T>, V> Entry; ///< One row of the table.
+
+    /**
+     * @brief Builds the index from a table sorted by low.
+     * @param entries The intervals and their values.
+     */
+    constexpr explicit FixedIntervalIndex(const Entry (&entries)[N])
+      : FixedIntervalIndex(entries, typename IntervalTreeDetail::MakeIndexSequence<N>::Type(),
+                           typename IntervalTreeDetail::MakeIndexSequence<Levels>::Type())
+    {
+    }
+
+    /**
+     * @brief Checks if a specific value is contained within any interval.
+     * @param value The value to check.
+     * @return True if the value is contained in any interval, false otherwise.
+     */
+    constexpr bool Contains(T value) const
+    {
+      return Overlaps(value, value);
+    }
+
+    /**
+     * @brief Checks if any intervals overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return True if there are overlapping intervals, false otherwise.
+     */
+    constexpr bool Overlaps(T low, T high) const
+    {
+      return Reaches(UpperBound(high, 0, std::integral_constant<size_t, N>()), low);
+    }
+
+    /**
+     * @brief Looks up the value of an interval containing a key.
+     * @param value The key to look up.
+     * @param fallback The result when no interval contains the key.
+     * @return The value of the containing interval with the highest low, or fallback.
+     */
+    constexpr V Find(T value, V fallback) const
+    {
+      return FoundIn(SkipBelow(value, UpperBound(value, 0, std::integral_constant<size_t, N>()),
+                               std::integral_constant<size_t, Levels - 1>()), fallback);
+    }
+
+    /**
+     * @brief Gets the number of intervals in the index.
+     * @return N.
+     */
+    constexpr size_t Size() const
+    {
+      return N;
+    }
+
+  private:
+    static const size_t Levels = IntervalTreeDetail::BitWidth(N); ///< Run lengths 1, 2, 4, ... up to the largest power of two <= N.
+
+    /**
+     * @brief The highest high of the runs of one length.
+     */
+    struct Runs
+    {
+      T maxes[N]; ///< maxes[i] is the highest high of the run starting at i, cut short at the end of the table.
+    };
+
+    T lows[N]; ///< Interval low bounds in ascending order.
+    T highs[N]; ///< Interval high bounds, in the order of lows.
+    T maxes[N]; ///< maxes[k] is the highest high among the first k + 1 intervals.
+    V values[N]; ///< The value of each interval.
+    Runs runs[Levels]; ///< runs[j] covers runs of 2^j intervals.
+
+    /**
+     * @brief Expands the table into the member arrays, one element per index and one run table per level.
+     */
+    template <size_t... I, size_t... J>
+    constexpr FixedIntervalIndex(const Entry (&entries)[N], IntervalTreeDetail::IndexSequence<I...>,
+                                 IntervalTreeDetail::IndexSequence<J...>)
+      : lows{ Checked(entries, I).first.low... },
+        highs{ entries[I].first.high... },
+        maxes{ RunningMax(entries, I)... },
+        values{ entries[I].second... },
+        runs{ MakeRuns(entries, J, IntervalTreeDetail::IndexSequence<I...>())... }
+    {
+    }
+
+    /**
+     * @brief Builds the run table of one level.
+     */
+    template <size_t... I>
+    static constexpr Runs MakeRuns(const Entry (&entries)[N], size_t level, IntervalTreeDetail::IndexSequence<I...>)
+    {
+      return Runs{ { RunMax(entries, level, I)... } };
+    }
+
+    /**
+     * @brief Computes the highest high of entries i to i + 2^level - 1, or to the end of the table.
+     */
+    static constexpr T RunMax(const Entry (&entries)[N], size_t level, size_t i)
+    {
+      return level == 0 ? entries[i].first.high
+        : i + (size_t(1) << (level - 1)) < N
+          ? Larger(RunMax(entries, level - 1, i), RunMax(entries, level - 1, i + (size_t(1) << (level - 1))))
+          : RunMax(entries, level - 1, i);
+    }
+
+    /**
+     * @brief Passes entry i through if it is valid and not below its predecessor.
+     */
+    static constexpr const Entry& Checked(const Entry (&entries)[N], size_t i)
+    {
+      return entries[i].first.low <= entries[i].first.high && (i == 0 || entries[i - 1].first.low <= entries[i].first.low)
+        ? entries[i]
+        : throw std::invalid_argument("Invalid table: intervals must be sorted by low, with low <= high.");
+    }
+
+    /**
+     * @brief Computes the highest high among entries 0 to i.
+     */
+    static constexpr T RunningMax(const Entry (&entries)[N], size_t i)
+    {
+      return i == 0 ? entries[0].first.high : Larger(RunningMax(entries, i - 1), entries[i].first.high);
+    }
+
+    static constexpr T Larger(T a, T b)
+    {
+      return a < b ? b : a;
+    }
+
+    /**
+     * @brief Counts the lows at or below key within [base, base + Count), given that every low before base is.
+     *
+     * Each step halves the window around a midpoint compare and the window
+     * size is a template argument, so the recursion unrolls completely.
+     */
+    template <size_t Count>
+    constexpr size_t UpperBound(T key, size_t base, std::integral_constant<size_t, Count>) const
+    {
+      return UpperBound(key, lows[base + Count / 2] <= key ? base + Count / 2 : base,
+                        std::integral_constant<size_t, Count - Count / 2>());
+    }
+
+    /**
+     * @brief The last step of UpperBound, on a single low.
+     */
+    constexpr size_t UpperBound(T key, size_t base, std::integral_constant<size_t, 1>) const
+    {
+      return base + (lows[base] <= key ? 1 : 0);
+    }
+
+    /**
+     * @brief Checks whether any of the first count intervals reaches low.
+     */
+    constexpr bool Reaches(size_t count, T low) const
+    {
+      return count != 0 && maxes[count - 1] >= low;
+    }
+
+    /**
+     * @brief Drops the trailing intervals of the first count that end below value, trying runs of 2^Level down to 1.
+     *
+     * Dropping is monotone, since a shorter tail of a tail that ends below the
+     * value does too, so trying each power of two once from the largest down
+     * finds the longest such tail. The levels are template arguments, so the
+     * recursion unrolls completely.
+     */
+    template <size_t Level>
+    constexpr size_t SkipBelow(T value, size_t count, std::integral_constant<size_t, Level>) const
+    {
+      return SkipBelow(value, Skip(value, count, Level), std::integral_constant<size_t, Level - 1>());
+    }
+
+    /**
+     * @brief The last step of SkipBelow, on single intervals.
+     */
+    constexpr size_t SkipBelow(T value, size_t count, std::integral_constant<size_t, 0>) const
+    {
+      return Skip(value, count, 0);
+    }
+
+    /**
+     * @brief Drops the last 2^level of the first count intervals if they all end below value.
+     */
+    constexpr size_t Skip(T value, size_t count, size_t level) const
+    {
+      return count >= (size_t(1) << level) && runs[level].maxes[count - (size_t(1) << level)] < value
+        ? count - (size_t(1) << level)
+        : count;
+    }
+
+    /**
+     * @brief Gets the value of the last of the first count intervals, which contains the key when count is not 0.
+     */
+    constexpr V FoundIn(size_t count, V fallback) const
+    {
+      return count != 0 ? values[count - 1] : fallback;
+    }
+};
+
+/**
+ * @brief Builds a FixedIntervalIndex, deducing its size from the table.
+ * @param entries The intervals and their values, sorted by low.
+ * @return The index over entries.
+ */
+template <typename T, typename V, size_t N>
+constexpr FixedIntervalIndex<T, V, N> MakeFixedIntervalIndex(const std::pair<Interval<T>, V> (&entries)[N])
+{
+  return FixedIntervalIndex<T, V, N>(entries);
+}
+
+#endif
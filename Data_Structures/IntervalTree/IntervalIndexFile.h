@@ -0,0 +1,178 @@
+//---------------------------------------------------------------------------
+
+#ifndef IntervalIndexFileH
+#define IntervalIndexFileH
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+/**
+ * @brief The on-disk format of a frozen interval index.
+ *
+ * A file is a fixed header followed by the lows, highs, subtree maxima and
+ * payloads of a StaticIntervalIndex, each as a flat array in Eytzinger order
+ * starting on a 64-byte boundary. The arrays are exactly what the index keeps
+ * in memory, so a reader can map the file and query it in place.
+ *
+ * Values are stored in the byte order of the machine that wrote them. The
+ * header records that order with EndianTag, and a reader with the other order
+ * rejects the file instead of byte swapping, which would defeat mapping it.
+ */
+namespace IntervalIndexFile
+{
+  static const char Magic[8] = { 'I', 'V', 'L', 'I', 'N', 'D', 'E', 'X' }; ///< The first eight bytes of every file.
+  static const uint32_t Version = 1; ///< Bumped on any change to the layout.
+  static const uint32_t EndianTag = 0x01020304; ///< Reads back as 0x04030201 on a machine of the other byte order.
+  static const uint64_t Alignment = 64; ///< Every array starts on a cache line.
+
+  /**
+   * @brief Distinguishes key types of the same size.
+   */
+  enum KeyKind
+  {
+    SignedKey = 1,
+    UnsignedKey = 2,
+    FloatingKey = 3
+  };
+
+  /**
+   * @brief The header at offset 0; all offsets are from the start of the file.
+   */
+  struct Header
+  {
+    char magic[8];
+    uint32_t endianTag;
+    uint32_t version;
+    uint32_t keyKind; ///< A KeyKind.
+    uint32_t keySize; ///< sizeof(T) of the writer.
+    uint32_t valueSize; ///< sizeof(V) of the writer.
+    uint32_t reserved; ///< Zero.
+    uint64_t count; ///< The number of intervals.
+    uint64_t lowsOffset;
+    uint64_t highsOffset;
+    uint64_t maxesOffset;
+    uint64_t dataOffset;
+    uint64_t fileSize; ///< The total size, padding included, so truncated files are caught.
+  };
+
+  /**
+   * @brief Gets the KeyKind of T.
+   */
+  template <typename T>
+  inline uint32_t KindOf()
+  {
+    static_assert(std::is_arithmetic<T>::value, "Only arithmetic keys can be saved.");
+    return std::is_floating_point<T>::value ? FloatingKey : std::is_signed<T>::value ? SignedKey : UnsignedKey;
+  }
+
+  /**
+   * @brief Rounds an offset up to the next array boundary.
+   */
+  inline uint64_t Align(uint64_t offset)
+  {
+    return (offset + Alignment - 1) & ~(Alignment - 1);
+  }
+
+  /**
+   * @brief Fills in a header for count intervals of key type T and payload type V.
+   */
+  template <typename T, typename V>
+  inline Header MakeHeader(uint64_t count)
+  {
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.endianTag = EndianTag;
+    header.version = Version;
+    header.keyKind = KindOf<T>();
+    header.keySize = sizeof(T);
+    header.valueSize = sizeof(V);
+    header.count = count;
+    header.lowsOffset = Align(sizeof(Header));
+    header.highsOffset = Align(header.lowsOffset + count * sizeof(T));
+    header.maxesOffset = Align(header.highsOffset + count * sizeof(T));
+    header.dataOffset = Align(header.maxesOffset + count * sizeof(T));
+    header.fileSize = Align(header.dataOffset + count * sizeof(V));
+    return header;
+  }
+
+  /**
+   * @brief Checks that a header describes a file of key type T and payload type V that this build can read.
+   * @param header The header as read from the file.
+   * @param size The actual size of the file.
+   * @param path The file name, for the error message.
+   * @throws std::runtime_error if the file is not an index, is truncated, or was written with other types or byte order.
+   */
+  template <typename T, typename V>
+  inline void Validate(const Header& header, uint64_t size, const std::string& path)
+  {
+    if(size < sizeof(Header) || std::memcmp(header.magic, Magic, sizeof(Magic)) != 0)
+    {
+      throw std::runtime_error("Not an interval index file: " + path);
+    }
+    if(header.endianTag != EndianTag)
+    {
+      throw std::runtime_error("Interval index file was written with the other byte order: " + path);
+    }
+    if(header.version != Version)
+    {
+      throw std::runtime_error("Unsupported interval index file version: " + path);
+    }
+    if(header.keyKind != KindOf<T>() || header.keySize != sizeof(T) || header.valueSize != sizeof(V))
+    {
+      throw std::runtime_error("Interval index file holds other key or payload types: " + path);
+    }
+    const Header expected = MakeHeader<T, V>(header.count);
+    if(header.count > std::numeric_limits<uint64_t>::max() / 4 / (sizeof(T) + sizeof(V)) ||
+       std::memcmp(&header, &expected, sizeof(Header)) != 0 || size < header.fileSize)
+    {
+      throw std::runtime_error("Interval index file is corrupt or truncated: " + path);
+    }
+  }
+
+  /**
+   * @brief Writes count elements and pads the file up to the next array boundary.
+   */
+  template <typename U>
+  inline void WriteArray(std::ofstream& out, const U* values, uint64_t count)
+  {
+    static const char zeros[Alignment] = {};
+    out.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(count * sizeof(U)));
+    uint64_t end = static_cast<uint64_t>(out.tellp());
+    out.write(zeros, static_cast<std::streamsize>(Align(end) - end));
+  }
+
+  /**
+   * @brief Writes a complete index file.
+   * @throws std::runtime_error if the file cannot be written.
+   */
+  template <typename T, typename V>
+  inline void Write(const std::string& path, const T* lows, const T* highs, const T* maxes, const V* data, uint64_t count)
+  {
+    static_assert(std::is_trivially_copyable<V>::value, "Only trivially copyable payloads can be saved; pointers would not survive a reload.");
+
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    if(!out)
+    {
+      throw std::runtime_error("Cannot open interval index file for writing: " + path);
+    }
+    const Header header = MakeHeader<T, V>(count);
+    WriteArray(out, &header, 1);
+    WriteArray(out, lows, count);
+    WriteArray(out, highs, count);
+    WriteArray(out, maxes, count);
+    WriteArray(out, data, count);
+    out.flush();
+    if(!out)
+    {
+      throw std::runtime_error("Cannot write interval index file: " + path);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,273 @@
+//---------------------------------------------------------------------------
+
+#ifndef IntervalJoinH
+#define IntervalJoinH
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "IntervalTree.h"
+
+namespace IntervalJoinDetail
+{
+  /**
+   * @brief A tree interval seen by the join: the bounds by value and the payload in place.
+   *
+   * The payload pointer stays valid because the cursor keeps the tree version alive.
+   */
+  template <typename T, typename V>
+  struct TreeEntry
+  {
+    Interval<T> interval; ///< The bounds.
+    const V* data; ///< The payload inside the node.
+  };
+
+  template <typename T>
+  const Interval<T>& IntervalOf(const Interval<T>& i)
+  {
+    return i;
+  }
+
+  template <typename T, typename V>
+  const Interval<T>& IntervalOf(const std::pair<Interval<T>, V>& entry)
+  {
+    return entry.first;
+  }
+
+  template <typename T, typename V>
+  const Interval<T>& IntervalOf(const TreeEntry<T, V>& entry)
+  {
+    return entry.interval;
+  }
+
+  /**
+   * @brief Feeds the join from a single-pass range sorted by low.
+   */
+  template <typename Iter>
+  class RangeSource
+  {
+    public:
+      typedef typename std::iterator_traits<Iter>::value_type Entry;
+      typedef typename std::decay<decltype(IntervalOf(std::declval<const Entry&>()))>::type Bounds;
+
+      RangeSource(Iter first, Iter last) : first(first), last(last) {}
+
+      bool IsDone() const { return first == last; }
+      Bounds Peek() const { return IntervalOf(*first); } ///< A copy, since an input iterator may return its element by value.
+
+      Entry Take()
+      {
+        Entry entry = *first;
+        ++first;
+        return entry;
+      }
+
+    private:
+      Iter first;
+      Iter last;
+  };
+
+  /**
+   * @brief Feeds the join from an in-order walk of an IntervalTree.
+   */
+  template <typename T, typename V, typename A, typename S>
+  class TreeSource
+  {
+    public:
+      typedef TreeEntry<T, V> Entry;
+
+      explicit TreeSource(const IntervalTree<T, V, A, S>& tree) : cursor(tree.InOrder()) {}
+
+      bool IsDone() const { return cursor.IsDone(); }
+      const Interval<T>& Peek() const { return cursor.Current().interval; }
+
+      Entry Take()
+      {
+        Entry entry = { cursor.Current().interval, &cursor.Current().data };
+        cursor.Next();
+        return entry;
+      }
+
+    private:
+      IntervalTreeDetail::InOrderCursor<Node<T, V, A> > cursor;
+  };
+
+  /**
+   * @brief Reports x against every active interval that still reaches it and drops the ones that end before it.
+   * @return False if the callback stopped the join.
+   */
+  template <typename Entry, typename Other, typename Report>
+  bool Probe(const Entry& x, std::vector<Other>& active, Report& report)
+  {
+    const auto low = IntervalOf(x).low;
+    for(size_t n = 0; n < active.size(); )
+    {
+      if(IntervalOf(active[n]).high < low)
+      {
+        // Later intervals start at or after low too, so this one can never match again
+        active[n] = std::move(active.back());
+        active.pop_back();
+      }
+      else
+      {
+        if(!report(x, active[n]))
+        {
+          return false;
+        }
+        ++n;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Adds x to its side's active set, first dropping the entries that end before x starts if the set has doubled.
+   *
+   * Probe only prunes a set when the other side advances, so a long run of one
+   * side would otherwise keep every interval of the run. Nothing after x can
+   * reach an entry that ends before x's low, so those go. Compacting only
+   * once the set has doubled since the last time keeps the cost O(1)
+   * amortized per interval and the set below twice the active intervals.
+   */
+  template <typename Entry>
+  void Activate(Entry x, std::vector<Entry>& active, size_t& limit)
+  {
+    static const size_t MinLimit = 16; ///< Small sets are not worth compacting.
+    if(active.size() >= limit)
+    {
+      const auto low = IntervalOf(x).low;
+      active.erase(std::remove_if(active.begin(), active.end(),
+        [&low](const Entry& e) { return IntervalOf(e).high < low; }), active.end());
+      limit = std::max(MinLimit, 2 * active.size());
+    }
+    active.push_back(std::move(x));
+  }
+
+  /**
+   * @brief Merges two sources by low, keeping the intervals of each side that may still overlap the other.
+   *
+   * When an interval is taken, every active interval of the other side
+   * starts at or before it, so it overlaps exactly those that have not ended
+   * yet. Each interval enters and leaves an active set once, and every other
+   * step of a probe reports a pair, so the join does O(n + m + k) work.
+   * Each active set holds at most twice the intervals of its side that have
+   * not ended yet, plus a small constant.
+   */
+  template <typename SourceA, typename SourceB, typename Callback>
+  void Sweep(SourceA& a, SourceB& b, Callback& callback)
+  {
+    typedef typename SourceA::Entry EntryA;
+    typedef typename SourceB::Entry EntryB;
+    std::vector<EntryA> activeA;
+    std::vector<EntryB> activeB;
+    size_t limitA = 0;
+    size_t limitB = 0;
+    auto reportA = [&callback](const EntryA& x, const EntryB& y)
+    {
+      return IntervalTreeDetail::Visit(callback, x, y);
+    };
+    auto reportB = [&callback](const EntryB& y, const EntryA& x)
+    {
+      return IntervalTreeDetail::Visit(callback, x, y);
+    };
+
+    bool started = false;
+    auto previous = decltype(a.Peek().low)();
+    while(!a.IsDone() || !b.IsDone())
+    {
+      bool takeA = !a.IsDone() && (b.IsDone() || a.Peek().low <= b.Peek().low);
+      auto low = takeA ? a.Peek().low : b.Peek().low;
+      if(started && low < previous)
+      {
+        throw std::invalid_argument("Invalid join input: intervals must be sorted by low.");
+      }
+      started = true;
+      previous = low;
+
+      if(takeA)
+      {
+        EntryA x = a.Take();
+        if(!Probe(x, activeB, reportA))
+        {
+          return;
+        }
+        if(!b.IsDone())
+        {
+          Activate(std::move(x), activeA, limitA); // Once B is exhausted, nothing can join x later
+        }
+        else if(activeB.empty())
+        {
+          return;
+        }
+      }
+      else
+      {
+        EntryB y = b.Take();
+        if(!Probe(y, activeA, reportB))
+        {
+          return;
+        }
+        if(!a.IsDone())
+        {
+          Activate(std::move(y), activeB, limitB);
+        }
+        else if(activeA.empty())
+        {
+          return;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Reports every overlapping pair of two interval streams sorted by low.
+ *
+ * The inputs are read once, front to back, and memory stays proportional to
+ * the intervals that may still overlap something ahead, so the streams can be
+ * larger than memory. The work is O(n + m + k) for k reported pairs. Pairs are reported
+ * once each, roughly in order of the later low of the two.
+ *
+ * @param firstA The beginning of the first range of Interval<T> or std::pair<Interval<T>, V> elements.
+ * @param lastA The end of the first range.
+ * @param firstB The beginning of the second range.
+ * @param lastB The end of the second range.
+ * @param callback The callable invoked as callback(const EntryA&, const EntryB&) with the range elements; returning false stops the join.
+ * @throws std::invalid_argument if either range is found out of order by low.
+ */
+template <typename IterA, typename IterB, typename Callback>
+void OverlapJoin(IterA firstA, IterA lastA, IterB firstB, IterB lastB, Callback callback)
+{
+  IntervalJoinDetail::RangeSource<IterA> a(firstA, lastA);
+  IntervalJoinDetail::RangeSource<IterB> b(firstB, lastB);
+  IntervalJoinDetail::Sweep(a, b, callback);
+}
+
+/**
+ * @brief Reports every overlapping pair of intervals from two trees, walking both in order at once.
+ *
+ * This replaces one Overlapping query per interval of a with a single merge of
+ * both trees, O(n + m + k). Besides the active intervals it needs one
+ * O(height) cursor per tree, and the trees may change while it runs.
+ *
+ * @param a The first tree.
+ * @param b The second tree.
+ * @param callback The callable invoked as callback(const Interval<T>&, const VA&, const Interval<T>&, const VB&) with an interval of a and one of b; returning false stops the join.
+ */
+template <typename T, typename VA, typename AA, typename SA, typename VB, typename AB, typename SB, typename Callback>
+void OverlapJoin(const IntervalTree<T, VA, AA, SA>& a, const IntervalTree<T, VB, AB, SB>& b, Callback callback)
+{
+  IntervalJoinDetail::TreeSource<T, VA, AA, SA> sourceA(a);
+  IntervalJoinDetail::TreeSource<T, VB, AB, SB> sourceB(b);
+  auto unpack = [&callback](const IntervalJoinDetail::TreeEntry<T, VA>& x, const IntervalJoinDetail::TreeEntry<T, VB>& y)
+  {
+    return IntervalTreeDetail::Visit(callback, x.interval, *x.data, y.interval, *y.data);
+  };
+  IntervalJoinDetail::Sweep(sourceA, sourceB, unpack);
+}
+
+#endif
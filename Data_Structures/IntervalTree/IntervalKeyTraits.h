@@ -0,0 +1,107 @@
+//---------------------------------------------------------------------------
+
+#ifndef IntervalKeyTraitsH
+#define IntervalKeyTraitsH
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+/**
+ * @tparam T The type of the interval bounds.
+ * @struct IntervalKeyTraits
+ * @brief Describes how the interval containers compare and store keys of type T.
+ *
+ * The primary template keeps keys as they are and compares them with the
+ * short-circuit operators, which is all an arbitrary ordered type allows.
+ * Arithmetic types get the specializations below.
+ */
+template <typename T, typename Enable = void>
+struct IntervalKeyTraits
+{
+  typedef T Key; ///< The type the flat containers store keys as.
+
+  /**
+   * @brief Gets a value no key compares below, used as the start of a running maximum.
+   */
+  static T Lowest()
+  {
+    return std::numeric_limits<T>::lowest();
+  }
+
+  static Key Encode(T value) { return value; } ///< Converts a key to its stored form.
+  static T Decode(Key key) { return key; } ///< Converts a stored key back.
+
+  /**
+   * @brief Checks whether [low1, high1] overlaps [low2, high2].
+   */
+  static bool Overlaps(T low1, T high1, T low2, T high2)
+  {
+    return low1 <= high2 && high1 >= low2;
+  }
+};
+
+/**
+ * @brief Integral keys: stored as 32-bit or 64-bit signed integers and compared without branches.
+ *
+ * Keys of up to 32 bits widen to int32_t so that char, short and unsigned
+ * keys all reach the 32-bit SIMD kernels. Unsigned keys as wide as their
+ * storage have the top bit flipped, which maps their order onto the signed
+ * order. Both comparisons of an overlap test are cheap and free of side
+ * effects, so they are combined with & instead of &&.
+ */
+template <typename T>
+struct IntervalKeyTraits<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type>
+{
+  typedef typename std::conditional<sizeof(T) <= 4, int32_t, int64_t>::type Key;
+
+  static T Lowest()
+  {
+    return std::numeric_limits<T>::lowest();
+  }
+
+  static Key Encode(T value)
+  {
+    return static_cast<Key>(static_cast<Unsigned>(value) ^ Bias);
+  }
+
+  static T Decode(Key key)
+  {
+    return static_cast<T>(static_cast<Unsigned>(key) ^ Bias);
+  }
+
+  static bool Overlaps(T low1, T high1, T low2, T high2)
+  {
+    return (low1 <= high2) & (high1 >= low2);
+  }
+
+  private:
+    typedef typename std::make_unsigned<Key>::type Unsigned;
+
+    /// The bit flipped to map unsigned keys onto the signed order; zero for every key that already fits.
+    static const Unsigned Bias = std::is_unsigned<T>::value && sizeof(T) == sizeof(Key) ? Unsigned(1) << (8 * sizeof(Key) - 1) : 0;
+};
+
+/**
+ * @brief Floating-point keys: the running maximum starts at lowest(), not at min(), which is the smallest positive value.
+ */
+template <typename T>
+struct IntervalKeyTraits<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+  typedef T Key;
+
+  static T Lowest()
+  {
+    return std::numeric_limits<T>::lowest();
+  }
+
+  static Key Encode(T value) { return value; }
+  static T Decode(Key key) { return key; }
+
+  static bool Overlaps(T low1, T high1, T low2, T high2)
+  {
+    return (low1 <= high2) & (high1 >= low2);
+  }
+};
+
+#endif
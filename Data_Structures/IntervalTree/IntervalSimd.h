@@ -0,0 +1,334 @@
+//---------------------------------------------------------------------------
+
+#ifndef IntervalSimdH
+#define IntervalSimdH
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "IntervalKeyTraits.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * @brief Block kernels shared by the wide interval indexes and the flat interval buffers.
+ *
+ * A block is Width consecutive lows and Width consecutive highs. The kernels
+ * compare a whole block against a query in one step: AVX2 when the compiler
+ * targets it (-mavx2 or -march=native), NEON on ARM, and a portable loop for
+ * every other key type or target.
+ */
+namespace IntervalSimd
+{
+  static const size_t Width = 8; ///< Intervals per block; 8 x 32-bit keys fill one AVX2 register.
+  static const size_t CacheLine = 64; ///< Blocks are laid out on this alignment.
+
+  /**
+   * @tparam U The element type.
+   * @class AlignedAllocator
+   * @brief A std::allocator replacement that places every allocation on a cache-line boundary.
+   */
+  template <typename U>
+  class AlignedAllocator
+  {
+    public:
+      typedef U value_type;
+
+      AlignedAllocator() {}
+      template <typename Other>
+      AlignedAllocator(const AlignedAllocator<Other>&) {}
+
+      /**
+       * @brief Allocates room for n elements aligned to CacheLine bytes.
+       */
+      U* allocate(size_t n)
+      {
+        // Over-allocate and keep the address malloc returned just before the aligned block
+        void* raw = std::malloc(n * sizeof(U) + CacheLine + sizeof(void*));
+        if(raw == nullptr)
+        {
+          throw std::bad_alloc();
+        }
+        uintptr_t start = reinterpret_cast<uintptr_t>(raw) + sizeof(void*);
+        uintptr_t aligned = (start + CacheLine - 1) & ~static_cast<uintptr_t>(CacheLine - 1);
+        reinterpret_cast<void**>(aligned)[-1] = raw;
+        return reinterpret_cast<U*>(aligned);
+      }
+
+      /**
+       * @brief Releases memory returned by allocate.
+       */
+      void deallocate(U* p, size_t)
+      {
+        std::free(reinterpret_cast<void**>(p)[-1]);
+      }
+
+      template <typename Other>
+      bool operator==(const AlignedAllocator<Other>&) const { return true; }
+      template <typename Other>
+      bool operator!=(const AlignedAllocator<Other>&) const { return false; }
+  };
+
+  /**
+   * @brief Gets the position of the lowest set bit of a non-zero mask.
+   */
+  inline unsigned LowestBit(unsigned mask)
+  {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+  }
+
+  /**
+   * @brief Gets the position of the highest set bit of a non-zero mask.
+   */
+  inline unsigned HighestBit(unsigned mask)
+  {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return 31u - static_cast<unsigned>(__builtin_clz(mask));
+#endif
+  }
+
+  /**
+   * @brief Finds the intervals of a block that overlap [low, high].
+   * @param lows The Width low bounds of the block.
+   * @param highs The Width high bounds of the block.
+   * @return A mask with bit j set when lows[j] <= high and highs[j] >= low.
+   */
+  template <typename T>
+  inline unsigned OverlapMask(const T* lows, const T* highs, T low, T high)
+  {
+    unsigned mask = 0;
+    for(size_t j = 0; j < Width; ++j)
+    {
+      mask |= static_cast<unsigned>(IntervalKeyTraits<T>::Overlaps(lows[j], highs[j], low, high)) << j;
+    }
+    return mask;
+  }
+
+#if defined(__AVX2__)
+  /**
+   * @brief AVX2 kernel for 32-bit integer keys: two compares cover the block.
+   */
+  inline unsigned OverlapMask(const int32_t* lows, const int32_t* highs, int32_t low, int32_t high)
+  {
+    __m256i l = _mm256_load_si256(reinterpret_cast<const __m256i*>(lows));
+    __m256i h = _mm256_load_si256(reinterpret_cast<const __m256i*>(highs));
+
+    // Overlap fails when low > high of the query or low of the query > high
+    __m256i miss = _mm256_or_si256(_mm256_cmpgt_epi32(l, _mm256_set1_epi32(high)),
+                                   _mm256_cmpgt_epi32(_mm256_set1_epi32(low), h));
+    return ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(miss))) & 0xFFu;
+  }
+
+  /**
+   * @brief AVX kernel for float keys.
+   */
+  inline unsigned OverlapMask(const float* lows, const float* highs, float low, float high)
+  {
+    __m256 hit = _mm256_and_ps(_mm256_cmp_ps(_mm256_load_ps(lows), _mm256_set1_ps(high), _CMP_LE_OQ),
+                               _mm256_cmp_ps(_mm256_load_ps(highs), _mm256_set1_ps(low), _CMP_GE_OQ));
+    return static_cast<unsigned>(_mm256_movemask_ps(hit));
+  }
+
+  /**
+   * @brief AVX2 kernel for 64-bit integer keys, two registers per block.
+   */
+  inline unsigned OverlapMask(const int64_t* lows, const int64_t* highs, int64_t low, int64_t high)
+  {
+    __m256i lowQuery = _mm256_set1_epi64x(low);
+    __m256i highQuery = _mm256_set1_epi64x(high);
+    unsigned mask = 0;
+    for(size_t half = 0; half < 2; ++half)
+    {
+      __m256i l = _mm256_load_si256(reinterpret_cast<const __m256i*>(lows + 4 * half));
+      __m256i h = _mm256_load_si256(reinterpret_cast<const __m256i*>(highs + 4 * half));
+      __m256i miss = _mm256_or_si256(_mm256_cmpgt_epi64(l, highQuery), _mm256_cmpgt_epi64(lowQuery, h));
+      mask |= (~static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(miss))) & 0xFu) << (4 * half);
+    }
+    return mask;
+  }
+
+  /**
+   * @brief AVX kernel for double keys, two registers per block.
+   */
+  inline unsigned OverlapMask(const double* lows, const double* highs, double low, double high)
+  {
+    __m256d lowQuery = _mm256_set1_pd(low);
+    __m256d highQuery = _mm256_set1_pd(high);
+    unsigned mask = 0;
+    for(size_t half = 0; half < 2; ++half)
+    {
+      __m256d hit = _mm256_and_pd(_mm256_cmp_pd(_mm256_load_pd(lows + 4 * half), highQuery, _CMP_LE_OQ),
+                                  _mm256_cmp_pd(_mm256_load_pd(highs + 4 * half), lowQuery, _CMP_GE_OQ));
+      mask |= static_cast<unsigned>(_mm256_movemask_pd(hit)) << (4 * half);
+    }
+    return mask;
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  /**
+   * @brief Packs two NEON lane masks of four lanes each into the low 8 bits.
+   */
+  inline unsigned NeonMask(uint32x4_t first, uint32x4_t second)
+  {
+    static const uint32_t weights[4] = { 1, 2, 4, 8 };
+    uint32x4_t w = vld1q_u32(weights);
+    return vaddvq_u32(vandq_u32(first, w)) | (vaddvq_u32(vandq_u32(second, w)) << 4);
+  }
+
+  /**
+   * @brief NEON kernel for 32-bit integer keys, two registers per block.
+   */
+  inline unsigned OverlapMask(const int32_t* lows, const int32_t* highs, int32_t low, int32_t high)
+  {
+    int32x4_t lowQuery = vdupq_n_s32(low);
+    int32x4_t highQuery = vdupq_n_s32(high);
+    uint32x4_t first = vandq_u32(vcleq_s32(vld1q_s32(lows), highQuery), vcgeq_s32(vld1q_s32(highs), lowQuery));
+    uint32x4_t second = vandq_u32(vcleq_s32(vld1q_s32(lows + 4), highQuery), vcgeq_s32(vld1q_s32(highs + 4), lowQuery));
+    return NeonMask(first, second);
+  }
+
+  /**
+   * @brief NEON kernel for float keys, two registers per block.
+   */
+  inline unsigned OverlapMask(const float* lows, const float* highs, float low, float high)
+  {
+    float32x4_t lowQuery = vdupq_n_f32(low);
+    float32x4_t highQuery = vdupq_n_f32(high);
+    uint32x4_t first = vandq_u32(vcleq_f32(vld1q_f32(lows), highQuery), vcgeq_f32(vld1q_f32(highs), lowQuery));
+    uint32x4_t second = vandq_u32(vcleq_f32(vld1q_f32(lows + 4), highQuery), vcgeq_f32(vld1q_f32(highs + 4), lowQuery));
+    return NeonMask(first, second);
+  }
+#endif
+
+  /**
+   * @tparam T The type of the interval bounds.
+   * @tparam V The type of the payload stored with each interval.
+   * @class FlatIntervals
+   * @brief Unsorted intervals in packed, block-padded arrays, scanned with one OverlapMask per block.
+   *
+   * Appends go to the end and removes swap the last interval into the hole,
+   * so the arrays stay dense and a scan reports hits in no particular order.
+   * Keys are stored encoded by IntervalKeyTraits, so integral bounds of any
+   * width reach the SIMD kernels.
+   */
+  template <typename T, typename V>
+  class FlatIntervals
+  {
+    public:
+      FlatIntervals() : count(0) {} ///< Constructs an empty set of intervals.
+
+      /**
+       * @brief Adds an interval at the end.
+       */
+      void Append(T low, T high, V payload)
+      {
+        if(count == lows.size())
+        {
+          // Grow a whole block at a time; the lanes past count are never reported
+          lows.resize(count + Width, Key());
+          highs.resize(count + Width, Key());
+        }
+        lows[count] = Traits::Encode(low);
+        highs[count] = Traits::Encode(high);
+        data.push_back(std::move(payload));
+        ++count;
+      }
+
+      /**
+       * @brief Removes one interval whose bounds both match.
+       * @return True if an interval was removed, false if none matched.
+       */
+      bool Remove(T low, T high)
+      {
+        const Key lowKey = Traits::Encode(low);
+        const Key highKey = Traits::Encode(high);
+        for(size_t n = 0; n < count; ++n)
+        {
+          if(lows[n] == lowKey && highs[n] == highKey)
+          {
+            // Fill the hole with the last interval so the arrays stay dense
+            --count;
+            lows[n] = lows[count];
+            highs[n] = highs[count];
+            data[n] = std::move(data[count]);
+            data.pop_back();
+            return true;
+          }
+        }
+        return false;
+      }
+
+      /**
+       * @brief Calls visit(low, high, payload) for every interval that overlaps [low, high].
+       * @return False if the visitor returned false to stop the scan.
+       */
+      template <typename Visitor>
+      bool Scan(T low, T high, Visitor visit) const
+      {
+        const Key lowKey = Traits::Encode(low);
+        const Key highKey = Traits::Encode(high);
+        for(size_t block = 0; block < count; block += Width)
+        {
+          unsigned hits = OverlapMask(&lows[block], &highs[block], lowKey, highKey);
+          if(count - block < Width)
+          {
+            hits &= (1u << (count - block)) - 1;
+          }
+          for(; hits; hits &= hits - 1)
+          {
+            size_t n = block + LowestBit(hits);
+            if(!visit(Traits::Decode(lows[n]), Traits::Decode(highs[n]), data[n]))
+            {
+              return false;
+            }
+          }
+        }
+        return true;
+      }
+
+      T Low(size_t n) const { return Traits::Decode(lows[n]); } ///< Gets the low bound of the interval at position n.
+      T High(size_t n) const { return Traits::Decode(highs[n]); } ///< Gets the high bound of the interval at position n.
+      V& Data(size_t n) { return data[n]; } ///< Accesses the payload at position n, for moving it out.
+      size_t Size() const { return count; } ///< Gets the number of intervals.
+
+      void Clear() ///< Removes every interval.
+      {
+        lows.clear();
+        highs.clear();
+        data.clear();
+        count = 0;
+      }
+
+    private:
+      typedef IntervalKeyTraits<T> Traits;
+      typedef typename Traits::Key Key; ///< Integral keys are widened to 32 or 64 bits so the kernels apply.
+      typedef std::vector<Key, AlignedAllocator<Key> > KeyArray;
+
+      KeyArray lows; ///< Low bounds, padded to whole blocks.
+      KeyArray highs; ///< High bounds, in the order of lows.
+      std::vector<V> data; ///< The payload of each interval.
+      size_t count; ///< The number of intervals.
+  };
+}
+
+#endif
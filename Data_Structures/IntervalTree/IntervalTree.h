@@ -8,9 +8,20 @@
 #include <algorithm>
 #include <memory>
 #include <utility>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <future>
 
 #include <sstream>
 
+#include "IntervalKeyTraits.h"
+
 /**
  * @struct Interval
  * @brief Represents an interval with a low and high bound.
@@ -25,14 +36,14 @@ struct Interval
    * @brief Default constructor initializes the interval to an empty or invalid state.
    * This could represent an interval where the lower bound is greater than the upper bound.
    */
-  Interval() : low(T()), high(T()) {}
+  constexpr Interval() : low(T()), high(T()) {}
 
   /**
    * @brief Constructs an Interval with specified low and high bounds.
    * @param l The lower bound.
    * @param h The upper bound.
    */
-  Interval(T l, T h) : low(l), high(h) {}
+  constexpr Interval(T l, T h) : low(l), high(h) {}
 
   // You could add comparison operators or other utility methods depending on your needs.
   bool operator<(const Interval<T>& other) const {
@@ -44,74 +55,1118 @@ struct Interval
 };
 
 /**
- * @tparam T The type of data stored in the node.
+ * @struct NoAugmentation
+ * @brief The default augmentation policy: nodes carry nothing beyond max and height.
+ *
+ * An augmentation policy is a struct the node inherits from, so an empty one
+ * costs no space. Its data summarizes the node's subtree, and its
+ * Recompute(interval, left, right) member rebuilds that summary from the
+ * node's own interval and its children's summaries (null for a missing child).
+ * The tree calls it wherever it updates max, which includes every rotation.
+ */
+struct NoAugmentation
+{
+  template <typename T>
+  void Recompute(const Interval<T>&, const NoAugmentation*, const NoAugmentation*) {} ///< Nothing to maintain.
+};
+
+/**
+ * @tparam T The type of the interval bounds.
+ * @struct SubtreeCount
+ * @brief Augmentation policy that keeps the size and the lowest high of each subtree.
+ *
+ * With it, CountOverlapping and CountContaining take whole subtrees that lie
+ * inside the query from their count instead of visiting them.
+ */
+template <typename T>
+struct SubtreeCount
+{
+  size_t count; ///< The number of intervals in the subtree.
+  T minHigh; ///< The lowest high bound in the subtree.
+
+  void Recompute(const Interval<T>& i, const SubtreeCount* left, const SubtreeCount* right) ///< Rebuilds the summary.
+  {
+    count = 1;
+    minHigh = i.high;
+    if(left)
+    {
+      count += left->count;
+      minHigh = std::min(minHigh, left->minHigh);
+    }
+    if(right)
+    {
+      count += right->count;
+      minHigh = std::min(minHigh, right->minHigh);
+    }
+  }
+};
+
+/**
+ * @tparam T The type of the interval bounds.
+ * @struct IntervalLength
+ * @brief A monoid for SubtreeAggregate that sums interval lengths (high - low).
+ *
+ * A monoid provides a Value type, Identity(), Of(interval) for a single
+ * interval, and an associative Combine(a, b).
+ */
+template <typename T>
+struct IntervalLength
+{
+  typedef T Value; ///< The type of the aggregate.
+  static Value Identity() { return T(); } ///< The aggregate of no intervals.
+  static Value Of(const Interval<T>& i) { return i.high - i.low; } ///< The aggregate of one interval.
+  static Value Combine(const Value& a, const Value& b) { return a + b; } ///< Merges two aggregates.
+};
+
+/**
+ * @tparam T The type of the interval bounds.
+ * @tparam Monoid The user-defined summary kept per subtree; see IntervalLength for the interface.
+ * @struct SubtreeAggregate
+ * @brief Augmentation policy that keeps a monoid value per subtree, on top of SubtreeCount.
+ *
+ * Aggregate(low, high) uses it to combine the values of all overlapping
+ * intervals, taking whole subtrees inside the query from their summary.
+ */
+template <typename T, typename Monoid>
+struct SubtreeAggregate : SubtreeCount<T>
+{
+  typedef typename Monoid::Value Value; ///< The type of the aggregate.
+  Value value; ///< The monoid value of the subtree.
+
+  void Recompute(const Interval<T>& i, const SubtreeAggregate* left, const SubtreeAggregate* right) ///< Rebuilds the summary.
+  {
+    SubtreeCount<T>::Recompute(i, left, right);
+    value = Monoid::Of(i);
+    if(left)
+    {
+      value = Monoid::Combine(left->value, value);
+    }
+    if(right)
+    {
+      value = Monoid::Combine(value, right->value);
+    }
+  }
+
+  static Value Of(const Interval<T>& i) { return Monoid::Of(i); } ///< The aggregate of one interval.
+  static Value Identity() { return Monoid::Identity(); } ///< The aggregate of no intervals.
+  static Value Combine(const Value& a, const Value& b) { return Monoid::Combine(a, b); } ///< Merges two aggregates.
+};
+
+/**
+ * @tparam T The type of the interval bounds.
+ * @tparam V The type of the payload stored in the node.
+ * @tparam A The augmentation policy the node inherits its subtree summary from.
  * @struct Node
  * @brief Represents a node in the interval tree.
  */
-template <typename T>
-struct Node
+template <typename T, typename V = std::shared_ptr<T>, typename A = NoAugmentation>
+struct Node : A
 {
   Interval<T> interval; ///< The interval associated with this node.
   T max; ///< The maximum value in the subtree (to help with overlap checks).
-  std::shared_ptr<Node<T>> left; ///< Pointer to the left child node.
-  std::shared_ptr<Node<T>> right; ///< Pointer to the right child node.
-  std::shared_ptr<T> data; ///< Pointer to hold the data of type T.
+  int height; ///< The height of the subtree rooted at this node (a leaf has height 1).
+  std::shared_ptr<Node<T, V, A> > left; ///< Pointer to the left child node.
+  std::shared_ptr<Node<T, V, A> > right; ///< Pointer to the right child node.
+  V data; ///< The payload, stored inline.
 
   /**
-   * @brief Constructs a Node with a given interval and optional data.
+   * @brief Constructs a Node with a given interval and a payload built in place.
    * @param i The interval for this node.
-   * @param d Optional data associated with the interval.
+   * @param args The arguments forwarded to the constructor of the payload; none value-initializes it.
+   */
+  template <typename... Args>
+  explicit Node(Interval<T> i, Args&&... args)
+    : interval(i), max(i.high), height(1), left(nullptr), right(nullptr), data(std::forward<Args>(args)...)
+  {
+    this->Recompute(interval, static_cast<const A*>(nullptr), static_cast<const A*>(nullptr));
+  }
+};
+
+namespace IntervalTreeDetail
+{
+  /**
+   * @brief Calls a query visitor, treating a void result as "keep going".
+   * @return False if the visitor returned false to stop the query, true otherwise.
+   */
+  template <typename Visitor, typename... Args>
+  auto Visit(Visitor& visit, Args&&... args)
+    -> typename std::enable_if<std::is_void<decltype(visit(std::forward<Args>(args)...))>::value, bool>::type
+  {
+    visit(std::forward<Args>(args)...);
+    return true;
+  }
+
+  /**
+   * @brief Calls a query visitor that returns whether the query should continue.
+   * @return False if the visitor returned false to stop the query, true otherwise.
+   */
+  template <typename Visitor, typename... Args>
+  auto Visit(Visitor& visit, Args&&... args)
+    -> typename std::enable_if<!std::is_void<decltype(visit(std::forward<Args>(args)...))>::value, bool>::type
+  {
+    return static_cast<bool>(visit(std::forward<Args>(args)...));
+  }
+
+  /**
+   * @tparam P The node pointer type held on the stack.
+   * @class NodeStack
+   * @brief Explicit traversal stack sized from the cached height of the subtree being walked.
+   *
+   * A depth-first walk keeps at most one pending node per level, so a stack of
+   * height + 1 slots never overflows. AVL trees of any size_t node count fit in
+   * the inline array; only a degenerate tree falls back to a heap buffer.
+   */
+  template <typename P>
+  class NodeStack
+  {
+    public:
+      static const int InlineCapacity = 96; ///< An AVL tree of 2^64 nodes is at most 93 levels high.
+
+      explicit NodeStack(int height) : items(inlineItems), top(0)
+      {
+        if(height + 1 > InlineCapacity)
+        {
+          heapItems.resize(height + 1);
+          items = heapItems.data();
+        }
+      }
+
+      NodeStack(const NodeStack&) = delete;
+      NodeStack& operator=(const NodeStack&) = delete;
+
+      void Push(P node) { items[top++] = node; } ///< Pushes a node onto the stack.
+      P Pop() { return items[--top]; } ///< Pops the most recently pushed node.
+      bool IsEmpty() const { return top == 0; } ///< Checks whether the stack is empty.
+
+    private:
+      P inlineItems[InlineCapacity]; ///< Storage for trees that respect the AVL bound.
+      std::vector<P> heapItems; ///< Storage for trees deeper than InlineCapacity.
+      P* items; ///< The active storage.
+      int top; ///< The number of nodes on the stack.
+  };
+
+  /**
+   * @tparam N The node type of the tree being walked.
+   * @class InOrderCursor
+   * @brief Walks the nodes of one tree version in ascending order of low, holding O(height) memory.
+   *
+   * The cursor holds a reference to the root it started from. Like a
+   * snapshot, that makes later changes to the tree copy the nodes they touch,
+   * so the walk stays valid and sees the version it started on.
+   */
+  template <typename N>
+  class InOrderCursor
+  {
+    public:
+      InOrderCursor() {} ///< Constructs a cursor that is already done.
+
+      /**
+       * @brief Positions the cursor on the lowest node under root.
+       * @param root The root of the version to walk.
+       * @param height The height of root, which bounds the stack.
+       */
+      InOrderCursor(const std::shared_ptr<const N>& root, int height) : root(root)
+      {
+        stack.reserve(height + 1);
+        Descend(root.get());
+      }
+
+      bool IsDone() const { return stack.empty(); } ///< Checks whether every node has been visited.
+      const N& Current() const { return *stack.back(); } ///< Gets the node under the cursor; the cursor must not be done.
+
+      /**
+       * @brief Moves to the next node in order: the lowest node of the right subtree, or the nearest unvisited ancestor.
+       */
+      void Next()
+      {
+        const N* node = stack.back();
+        stack.pop_back();
+        Descend(node->right.get());
+      }
+
+    private:
+      std::shared_ptr<const N> root; ///< Keeps the version being walked alive.
+      std::vector<const N*> stack; ///< The node under the cursor on top, then its unvisited ancestors.
+
+      void Descend(const N* node)
+      {
+        for(; node; node = node->left.get())
+        {
+          stack.push_back(node);
+        }
+      }
+  };
+
+  /**
+   * @tparam N The node type of the tree being walked.
+   * @class OverlapCursor
+   * @brief Walks the nodes of one tree version that overlap a range, in ascending order of low, holding O(height) memory.
+   *
+   * This is the in-order walk of InOrderCursor with the pruning of
+   * FindOverlapping: a subtree whose max is below the range is never entered,
+   * and the walk ends at the first node whose low is past it, since every
+   * later node starts at or after that low.
+   */
+  template <typename N>
+  class OverlapCursor
+  {
+    public:
+      typedef decltype(std::declval<N>().interval.low) Key; ///< The type of the interval bounds.
+
+      OverlapCursor() : low(), high() {} ///< Constructs a cursor that is already done.
+
+      /**
+       * @brief Positions the cursor on the lowest node under root that overlaps [low, high].
+       * @param root The root of the version to walk.
+       * @param height The height of root, which bounds the stack.
+       * @param low The lower bound of the range.
+       * @param high The upper bound of the range.
+       */
+      OverlapCursor(const std::shared_ptr<const N>& root, int height, Key low, Key high) : root(root), low(low), high(high)
+      {
+        stack.reserve(height + 1);
+        Descend(root.get());
+        Settle();
+      }
+
+      bool IsDone() const { return stack.empty(); } ///< Checks whether every overlapping node has been visited.
+      const N& Current() const { return *stack.back(); } ///< Gets the node under the cursor; the cursor must not be done.
+
+      /**
+       * @brief Moves to the next overlapping node in order.
+       */
+      void Next()
+      {
+        Advance();
+        Settle();
+      }
+
+    private:
+      std::shared_ptr<const N> root; ///< Keeps the version being walked alive.
+      std::vector<const N*> stack; ///< The node under the cursor on top, then its unvisited ancestors that may still overlap.
+      Key low; ///< The lower bound of the range.
+      Key high; ///< The upper bound of the range.
+
+      void Descend(const N* node)
+      {
+        for(; node && !(node->max < low); node = node->left.get()) // Nothing below a max under low reaches the range
+        {
+          stack.push_back(node);
+        }
+      }
+
+      /**
+       * @brief Leaves the node on top, moving into its right subtree unless its low is already past the range.
+       */
+      void Advance()
+      {
+        const N* node = stack.back();
+        stack.pop_back();
+        if(high < node->interval.low)
+        {
+          stack.clear(); // Every node still ahead starts at or after this one
+          return;
+        }
+        Descend(node->right.get());
+      }
+
+      /**
+       * @brief Skips nodes that reach below the range but end before it, until an overlapping node is on top.
+       */
+      void Settle()
+      {
+        while(!stack.empty() && (stack.back()->interval.high < low || high < stack.back()->interval.low))
+        {
+          Advance();
+        }
+      }
+  };
+
+  /**
+   * @tparam Cursor InOrderCursor or OverlapCursor.
+   * @class CursorIterator
+   * @brief A forward iterator over the nodes a cursor visits.
+   *
+   * Dereferencing gives the node itself, whose interval and data members are
+   * the interval and its payload. An iterator owns its cursor, so copying one
+   * copies an O(height) stack; a default-constructed iterator is the end.
+   */
+  template <typename Cursor>
+  class CursorIterator
+  {
+    public:
+      typedef typename std::decay<decltype(std::declval<const Cursor&>().Current())>::type value_type;
+      typedef const value_type& reference;
+      typedef const value_type* pointer;
+      typedef std::ptrdiff_t difference_type;
+      typedef std::forward_iterator_tag iterator_category;
+
+      CursorIterator() {} ///< Constructs the end iterator.
+      explicit CursorIterator(const Cursor& cursor) : cursor(cursor) {} ///< Starts at the node under cursor.
+
+      reference operator*() const { return cursor.Current(); }
+      pointer operator->() const { return &cursor.Current(); }
+
+      CursorIterator& operator++()
+      {
+        cursor.Next();
+        return *this;
+      }
+
+      CursorIterator operator++(int)
+      {
+        CursorIterator previous = *this;
+        cursor.Next();
+        return previous;
+      }
+
+      /**
+       * @brief Iterators of the same walk are equal when both are done or both stand on the same node.
+       */
+      bool operator==(const CursorIterator& other) const
+      {
+        return cursor.IsDone() ? other.cursor.IsDone() : !other.cursor.IsDone() && &cursor.Current() == &other.cursor.Current();
+      }
+
+      bool operator!=(const CursorIterator& other) const { return !(*this == other); }
+
+    private:
+      Cursor cursor; ///< The walk, positioned on the current node.
+  };
+
+  /**
+   * @tparam Cursor InOrderCursor or OverlapCursor.
+   * @class CursorRange
+   * @brief A lazy range over the nodes a cursor visits, usable in range-based for loops and with the standard algorithms.
+   */
+  template <typename Cursor>
+  class CursorRange
+  {
+    public:
+      typedef CursorIterator<Cursor> iterator;
+      typedef CursorIterator<Cursor> const_iterator;
+
+      explicit CursorRange(const Cursor& first) : first(first) {} ///< Covers the nodes from the one under first onward.
+
+      iterator begin() const { return iterator(first); }
+      iterator end() const { return iterator(); }
+      bool empty() const { return first.IsDone(); }
+
+    private:
+      Cursor first; ///< The cursor positioned on the first node.
+  };
+
+  /**
+   * @brief A query of a batch, copied next to its bounds so sweeps stay in contiguous memory.
+   */
+  template <typename T>
+  struct BatchQuery
+  {
+    T low; ///< The lower bound of the query (the point itself for point queries).
+    T high; ///< The upper bound of the query.
+    size_t index; ///< The position of the query in the caller's batch.
+  };
+}
+
+/**
+ * @tparam T The type of the interval bounds.
+ * @tparam V The type of the payload of each hit.
+ * @struct IntervalBatchResult
+ * @brief The results of a batch query in compressed sparse row (CSR) form.
+ *
+ * The hits of query q are hits[offsets[q]] to hits[offsets[q + 1] - 1], so
+ * offsets always holds one more entry than there were queries.
+ */
+template <typename T, typename V = std::shared_ptr<T> >
+struct IntervalBatchResult
+{
+  std::vector<size_t> offsets; ///< The start of each query's hits, followed by the total hit count.
+  std::vector<std::pair<Interval<T>, V> > hits; ///< The hits of every query, grouped by query.
+
+  /**
+   * @brief Gets the number of queries in the batch.
+   * @return The number of queries.
+   */
+  size_t Size() const
+  {
+    return offsets.empty() ? 0 : offsets.size() - 1;
+  }
+
+  /**
+   * @brief Gets the number of hits of one query.
+   * @param query The position of the query in the batch.
+   * @return The number of intervals the query matched.
+   */
+  size_t Count(size_t query) const
+  {
+    return offsets[query + 1] - offsets[query];
+  }
+};
+
+namespace IntervalTreeDetail
+{
+  /**
+   * @brief Starts loading the cache line at address, ahead of the access that reads it.
+   */
+  inline void Prefetch(const void* address)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+  }
+
+  /**
+   * @tparam Walk The tree being walked; see below.
+   * @brief Answers a batch of point queries by interleaving their walks, so the cache misses of different points overlap.
+   *
+   * On a tree much larger than the cache, one walk is a chain of dependent
+   * misses: a node's children are known only once the node has arrived. Here
+   * up to group walks are in flight, each with its own stack, and they take
+   * turns advancing one node. Every node pushed is prefetched, so by the time
+   * a walk's turn comes round again its next node has had the other walks'
+   * steps to arrive. A finished walk hands its slot to the next point. This is
+   * asynchronous memory access chaining (AMAC) written out by hand, since the
+   * library targets C++11 and has no coroutines.
+   *
+   * Walk provides a node handle type Ref, Root(), Depth() (the height of the
+   * root, which bounds a stack), Valid(ref), Prefetch(ref), Low(ref),
+   * High(ref), Max(ref), Left(ref) and Right(ref).
+   *
+   * @param walk The tree to walk.
+   * @param points The query points.
+   * @param count The number of query points.
+   * @param group The number of walks in flight at once.
+   * @param found Receives (query, node) for every hit; the hits of one query keep their walk order.
+   */
+  template <typename Walk, typename T>
+  void InterleavedContaining(const Walk& walk, const T* points, size_t count, size_t group,
+    std::vector<std::pair<size_t, typename Walk::Ref> >& found)
+  {
+    typedef typename Walk::Ref Ref;
+    struct Lane
+    {
+      T point; ///< The point this walk answers.
+      size_t query; ///< The position of the point in the batch.
+      Ref* stack; ///< The lane's region of the shared stack storage.
+      size_t top; ///< The number of nodes on the stack.
+    };
+
+    if(count == 0 || !walk.Valid(walk.Root()))
+    {
+      return;
+    }
+    group = std::max<size_t>(1, std::min(group, count));
+    const size_t depth = static_cast<size_t>(walk.Depth()) + 1; // A depth-first walk keeps at most one pending node per level
+    std::vector<Ref> stacks(group * depth);
+    std::vector<Lane> lanes(group);
+    size_t next = 0;
+
+    auto start = [&](Lane& lane) -> bool
+    {
+      if(next == count)
+      {
+        return false;
+      }
+      lane.point = points[next];
+      lane.query = next++;
+      lane.stack[0] = walk.Root();
+      lane.top = 1;
+      return true;
+    };
+
+    for(size_t l = 0; l < group; ++l)
+    {
+      lanes[l].stack = stacks.data() + l * depth;
+      start(lanes[l]);
+    }
+
+    size_t active = group;
+    size_t l = 0;
+    while(active > 0)
+    {
+      Lane& lane = lanes[l];
+      Ref node = lane.stack[--lane.top];
+      if(walk.Max(node) >= lane.point)
+      {
+        if(walk.Low(node) <= lane.point)
+        {
+          if(walk.High(node) >= lane.point)
+          {
+            found.push_back(std::make_pair(lane.query, node));
+          }
+          Ref right = walk.Right(node);
+          if(walk.Valid(right))
+          {
+            walk.Prefetch(right);
+            lane.stack[lane.top++] = right;
+          }
+        }
+
+        // Pushed last so the left subtree is visited first, as in a single walk
+        Ref left = walk.Left(node);
+        if(walk.Valid(left))
+        {
+          walk.Prefetch(left);
+          lane.stack[lane.top++] = left;
+        }
+      }
+
+      if(lane.top == 0 && !start(lane))
+      {
+        lanes[l] = lanes[--active]; // The last walk in flight moves into this slot and takes the next turn
+      }
+      else
+      {
+        ++l;
+      }
+      if(l >= active)
+      {
+        l = 0;
+      }
+    }
+  }
+
+  /**
+   * @brief Lays out (query, node) hits in CSR form in the caller's query order.
+   *
+   * A counting sort by query, so the hits of one query keep the order they were found in.
+   *
+   * @param found The hits, in any order across queries.
+   * @param count The number of queries in the batch.
+   * @param result Receives the offsets and the hits.
+   * @param entry Converts a node to the std::pair<Interval<T>, V> stored for it.
+   */
+  template <typename Ref, typename Result, typename Entry>
+  void GatherBatch(const std::vector<std::pair<size_t, Ref> >& found, size_t count, Result& result, Entry entry)
+  {
+    result.offsets.assign(count + 1, 0);
+    for(size_t h = 0; h < found.size(); ++h)
+    {
+      result.offsets[found[h].first + 1]++;
+    }
+    for(size_t q = 0; q < count; ++q)
+    {
+      result.offsets[q + 1] += result.offsets[q];
+    }
+    std::vector<size_t> cursor(result.offsets.begin(), result.offsets.end() - 1);
+    result.hits.resize(found.size());
+    for(size_t h = 0; h < found.size(); ++h)
+    {
+      result.hits[cursor[found[h].first]++] = entry(found[h].second);
+    }
+  }
+}
+
+/**
+ * @struct IntervalTreeStats
+ * @brief The work recorded by a statistics policy and the shape of the tree, as returned by IntervalTree::Stats().
+ *
+ * The counters stay zero under NoStats; the shape is measured on every call.
+ */
+struct IntervalTreeStats
+{
+  uint64_t queries; ///< The number of tree walks made by queries.
+  uint64_t nodesVisited; ///< The nodes those walks examined.
+  uint64_t subtreesPruned; ///< The subtrees they skipped because the subtree max was below the query.
+  uint64_t results; ///< The intervals they reported.
+  uint64_t rotations; ///< The single rotations made by Insert, Remove and Update; a double rotation counts twice.
+  std::vector<size_t> depths; ///< depths[d] is the number of nodes d levels below the root.
+  size_t balances[3]; ///< The number of nodes whose left subtree is one level lower than, as high as, and one level higher than the right.
+
+  IntervalTreeStats() : queries(0), nodesVisited(0), subtreesPruned(0), results(0), rotations(0), balances() {}
+};
+
+/**
+ * @struct NoStats
+ * @brief The default statistics policy: records nothing and compiles to nothing.
+ *
+ * A statistics policy is a base of the tree, so an empty one costs no space.
+ * Each query walk counts into a local Tally and hands it to Record() once at
+ * the end, so the hot loop never touches shared memory. Rotated() is called
+ * for every rotation, Read() copies the counters out and Reset() clears them.
+ */
+struct NoStats
+{
+  /**
+   * @brief The counts of one query walk; every method is empty, so none of the counting survives inlining.
+   */
+  struct Tally
+  {
+    void Visited() {}
+    void Pruned() {}
+    void Reported() {}
+  };
+
+  void Record(const Tally&) const {}
+  void Rotated() {}
+  void Read(IntervalTreeStats&) const {}
+  void Reset() {}
+};
+
+/**
+ * @struct QueryStats
+ * @brief Statistics policy that counts nodes visited, subtrees pruned, results and rotations.
+ *
+ * The counters are relaxed atomics, so concurrent queries may record into the
+ * same tree. Each query adds its tally once, which keeps the cost to a few
+ * register increments per node plus four atomic adds per query. Copies of the
+ * tree, snapshots included, start from the counts of the original.
+ */
+struct QueryStats
+{
+  /**
+   * @brief The counts of one query walk, kept in registers until Record().
    */
-  Node(Interval<T> i, std::shared_ptr<T> d = nullptr)
-    : interval(i), max(i.high), left(nullptr), right(nullptr), data(d) {}
+  struct Tally
+  {
+    uint64_t visited; ///< The nodes examined.
+    uint64_t pruned; ///< The subtrees skipped by max.
+    uint64_t reported; ///< The intervals reported.
+
+    Tally() : visited(0), pruned(0), reported(0) {}
+    void Visited() { ++visited; }
+    void Pruned() { ++pruned; }
+    void Reported() { ++reported; }
+  };
+
+  QueryStats() : queries(0), visited(0), pruned(0), results(0), rotations(0) {}
+  QueryStats(const QueryStats& other) : queries(0), visited(0), pruned(0), results(0), rotations(0) { Assign(other); }
+
+  QueryStats& operator=(const QueryStats& other)
+  {
+    Assign(other);
+    return *this;
+  }
+
+  void Record(const Tally& tally) const ///< Adds the counts of one query walk.
+  {
+    queries.fetch_add(1, std::memory_order_relaxed);
+    visited.fetch_add(tally.visited, std::memory_order_relaxed);
+    pruned.fetch_add(tally.pruned, std::memory_order_relaxed);
+    results.fetch_add(tally.reported, std::memory_order_relaxed);
+  }
+
+  void Rotated() ///< Counts one rotation.
+  {
+    rotations.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void Read(IntervalTreeStats& stats) const ///< Copies the counters out.
+  {
+    stats.queries = queries.load(std::memory_order_relaxed);
+    stats.nodesVisited = visited.load(std::memory_order_relaxed);
+    stats.subtreesPruned = pruned.load(std::memory_order_relaxed);
+    stats.results = results.load(std::memory_order_relaxed);
+    stats.rotations = rotations.load(std::memory_order_relaxed);
+  }
+
+  void Reset() ///< Sets every counter back to zero.
+  {
+    queries.store(0, std::memory_order_relaxed);
+    visited.store(0, std::memory_order_relaxed);
+    pruned.store(0, std::memory_order_relaxed);
+    results.store(0, std::memory_order_relaxed);
+    rotations.store(0, std::memory_order_relaxed);
+  }
+
+  private:
+    mutable std::atomic<uint64_t> queries; ///< Mutable because queries are const.
+    mutable std::atomic<uint64_t> visited;
+    mutable std::atomic<uint64_t> pruned;
+    mutable std::atomic<uint64_t> results;
+    std::atomic<uint64_t> rotations;
+
+    void Assign(const QueryStats& other)
+    {
+      queries.store(other.queries.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      visited.store(other.visited.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      pruned.store(other.pruned.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      results.store(other.results.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      rotations.store(other.rotations.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
 };
 
-/**
- * @tparam T The type of data stored in the interval tree.
- * @class IntervalTree
- * @brief Represents an interval tree for managing intervals.
- */
-template <typename T = int>
-class IntervalTree
-{
-  public:
-    IntervalTree() : Root(nullptr), size(0) {} ///< Constructs an empty IntervalTree.
+/**
+ * @tparam T The type of the interval bounds.
+ * @tparam V The type of the payload stored with each interval. It lives inline
+ *           in the node and is moved, not copied, on insertion; it must be
+ *           copyable so that snapshots can copy shared nodes. The default
+ *           keeps a std::shared_ptr<T> per interval, as earlier versions did.
+ * @tparam A The augmentation policy that summarizes each subtree, such as
+ *           SubtreeCount or SubtreeAggregate; see NoAugmentation.
+ * @tparam S The statistics policy, NoStats or QueryStats, that decides what
+ *           Stats() can report about the work done by queries and inserts.
+ * @class IntervalTree
+ * @brief Represents an interval tree for managing intervals.
+ *
+ * Thread safety: the const query methods may run concurrently from any number
+ * of threads, provided no thread modifies the tree at the same time. Queries
+ * walk the nodes through raw pointers and never touch their reference counts.
+ * Visitors receive the payload by reference; only the methods that return or
+ * write results copy it.
+ *
+ * Copies are persistent versions: copying a tree, or calling Snapshot(), shares
+ * every node in O(1). A modification then copies only the O(log n) nodes on its
+ * path that are still shared with another version, so unchanged subtrees stay
+ * shared. Versions are independent: a snapshot may be queried from other
+ * threads while the tree it was taken from keeps changing.
+ */
+template <typename T = int, typename V = std::shared_ptr<T>, typename A = NoAugmentation, typename S = NoStats>
+class IntervalTree : private S
+{
+  public:
+    IntervalTree() : Root(nullptr), size(0) {} ///< Constructs an empty IntervalTree.
+
+    /**
+     * @brief Constructs a balanced IntervalTree from a range of intervals in O(n log n).
+     * @param first The beginning of the range of Interval<T> or std::pair<Interval<T>, V> elements.
+     * @param last The end of the range.
+     * @param parallel Sorts the range on all hardware threads when true.
+     */
+    template <typename Iter>
+    IntervalTree(Iter first, Iter last, bool parallel = false) : Root(nullptr), size(0)
+    {
+      BulkInsert(first, last, parallel);
+    }
+
+    /**
+     * @brief Frees the nodes no other version shares, without recursing, so teardown takes no stack frame per level.
+     */
+    ~IntervalTree()
+    {
+      Release(std::move(Root));
+    }
+
+    IntervalTree(const IntervalTree&) = default; ///< Shares every node of the other tree in O(1), like Snapshot().
+
+    /**
+     * @brief Takes over the nodes of the other tree, which is left empty.
+     */
+    IntervalTree(IntervalTree&& other) : S(static_cast<const S&>(other)), Root(std::move(other.Root)), size(other.size)
+    {
+      other.size = 0;
+    }
+
+    /**
+     * @brief Shares every node of the other tree in O(1), like Snapshot(), and frees the nodes only this tree held.
+     */
+    IntervalTree& operator=(const IntervalTree& other)
+    {
+      if(this != &other)
+      {
+        S::operator=(static_cast<const S&>(other));
+        std::shared_ptr<Node<T, V, A> > old = std::move(Root);
+        Root = other.Root;
+        size = other.size;
+        Release(std::move(old)); // After taking the new root, so nodes both versions share only lose a reference
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Takes over the nodes of the other tree, which is left empty, and frees the nodes only this tree held.
+     */
+    IntervalTree& operator=(IntervalTree&& other)
+    {
+      if(this != &other)
+      {
+        S::operator=(static_cast<const S&>(other));
+        Release(std::move(Root));
+        Root = std::move(other.Root);
+        size = other.size;
+        other.size = 0;
+      }
+      return *this;
+    }
+
+    void Insert(T low, T high, V data = V()); ///< Inserts a new interval into the tree.
+    void Insert(Interval<T> i, V data = V()); ///< Inserts a new interval into the tree.
+
+    /**
+     * @brief Inserts a new interval, constructing its payload in place inside the new node.
+     * @param low The lower bound of the interval.
+     * @param high The upper bound of the interval.
+     * @param args The arguments forwarded to the constructor of V.
+     */
+    template <typename... Args>
+    void Emplace(T low, T high, Args&&... args);
+
+    /**
+     * @brief Removes one interval whose bounds both match, rebalancing the tree on the way up.
+     * @param i The interval to remove.
+     * @return True if an interval was removed, false if none matched.
+     */
+    bool Remove(Interval<T> i);
+
+    /**
+     * @brief Removes one interval whose bounds and payload both match.
+     *
+     * Intervals with equal bounds are told apart by comparing payloads with
+     * operator==; for std::shared_ptr payloads that is pointer identity.
+     *
+     * @param i The interval to remove.
+     * @param data The payload of the interval to remove.
+     * @return True if an interval was removed, false if none matched.
+     */
+    bool Remove(Interval<T> i, const V& data);
+
+    /**
+     * @brief Replaces an interval and its payload.
+     *
+     * When both intervals share the same low bound, the node stays where it is:
+     * its payload is replaced and, if high changed, max is fixed along the
+     * single path from the root. Otherwise the old interval is removed and the
+     * new one inserted. Update(i, i, data) therefore only swaps the payload.
+     *
+     * @param oldInterval The interval to replace.
+     * @param newInterval The interval to store instead.
+     * @param newData The payload for the new interval.
+     * @return True if oldInterval was found; the new interval is stored either way.
+     */
+    bool Update(Interval<T> oldInterval, Interval<T> newInterval, V newData = V());
+
+    /**
+     * @brief Inserts a range of intervals and rebuilds the tree perfectly balanced.
+     *
+     * The new intervals are sorted by low, merged with the intervals already in
+     * the tree, and the tree is rebuilt bottom-up with max computed in a single
+     * post-order pass. This costs O(n + m log m) for m new intervals, instead of
+     * m separate rebalancing inserts.
+     *
+     * @param first The beginning of the range of Interval<T> or std::pair<Interval<T>, V> elements.
+     * @param last The end of the range.
+     * @param parallel Sorts the range on all hardware threads when true.
+     */
+    template <typename Iter>
+    void BulkInsert(Iter first, Iter last, bool parallel = false);
+
+    /**
+     * @brief Inserts every interval of a container; see BulkInsert(Iter, Iter, bool).
+     * @param range A container of Interval<T> or std::pair<Interval<T>, V> elements.
+     * @param parallel Sorts the range on all hardware threads when true.
+     */
+    template <typename Range>
+    void BulkInsert(const Range& range, bool parallel = false)
+    {
+      BulkInsert(std::begin(range), std::end(range), parallel);
+    }
+
+    /**
+     * @brief Takes an immutable point-in-time version of the tree in O(1).
+     *
+     * The snapshot shares all its nodes with the tree. Later changes to the tree
+     * copy the nodes they touch instead of modifying them, so the snapshot never
+     * sees them.
+     *
+     * @return The current version of the tree.
+     */
+    const IntervalTree<T, V, A, S> Snapshot() const
+    {
+      return *this;
+    }
+
+    /**
+     * @brief Finds all intervals that contain a specific value.
+     * @param value The value to check for containment.
+     * @return A vector of intervals that contain the specified value.
+     */
+    std::vector<std::pair<Interval<T>, V> > Containing(T value) const;
+
+    /**
+     * @brief Finds all intervals that overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return A vector of intervals that overlap with the specified range.
+     */
+    std::vector<std::pair<Interval<T>, V> > Overlapping(T low, T high) const;
+
+    /**
+     * @brief Finds all intervals that contain a specific value into a caller-owned buffer.
+     *
+     * The buffer is cleared first but keeps its capacity, so reusing it across
+     * queries avoids the allocation made by Containing(T).
+     *
+     * @param value The value to check for containment.
+     * @param result The buffer that receives the intervals that contain the value.
+     */
+    void Containing(T value, std::vector<std::pair<Interval<T>, V> >& result) const;
+
+    /**
+     * @brief Finds all intervals that overlap with a given range into a caller-owned buffer.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @param result The buffer that receives the overlapping intervals; it is cleared first but keeps its capacity.
+     */
+    void Overlapping(T low, T high, std::vector<std::pair<Interval<T>, V> >& result) const;
+
+    /**
+     * @brief Calls a visitor for every interval that contains a specific value, without allocating.
+     *
+     * The visitor is called as visit(const Interval<T>&, const V&).
+     * If it returns a value convertible to bool, returning false stops the query.
+     *
+     * @param value The value to check for containment.
+     * @param visit The callable invoked for each containing interval.
+     */
+    template <typename Visitor>
+    void ForEachContaining(T value, Visitor visit) const;
+
+    /**
+     * @brief Calls a visitor for every interval that overlaps with a given range, without allocating.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @param visit The callable invoked as visit(const Interval<T>&, const V&); returning false stops the query.
+     */
+    template <typename Visitor>
+    void ForEachOverlapping(T low, T high, Visitor visit) const;
+
+    /**
+     * @brief Writes every interval that contains a specific value to an output iterator.
+     * @param value The value to check for containment.
+     * @param out The output iterator that receives std::pair<Interval<T>, V> elements.
+     * @return The output iterator past the last element written.
+     */
+    template <typename OutputIt>
+    OutputIt CopyContaining(T value, OutputIt out) const;
+
+    /**
+     * @brief Writes every interval that overlaps with a given range to an output iterator.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @param out The output iterator that receives std::pair<Interval<T>, V> elements.
+     * @return The output iterator past the last element written.
+     */
+    template <typename OutputIt>
+    OutputIt CopyOverlapping(T low, T high, OutputIt out) const;
+
+    /**
+     * @brief Finds the intervals containing each of a batch of points in one coordinated traversal.
+     *
+     * The points are sorted internally and swept through the tree together, so
+     * each node is visited once for all the points that can still reach it
+     * rather than once per point.
+     *
+     * @param points The query points, in any order.
+     * @param count The number of query points.
+     * @return The hits of each point, in the order the points were given.
+     */
+    IntervalBatchResult<T, V> Containing(const T* points, size_t count) const;
+
+    /**
+     * @brief Finds the intervals overlapping each of a batch of ranges in one coordinated traversal.
+     * @param ranges The query ranges, in any order.
+     * @param count The number of query ranges.
+     * @return The hits of each range, in the order the ranges were given.
+     */
+    IntervalBatchResult<T, V> Overlapping(const Interval<T>* ranges, size_t count) const;
+
+    /**
+     * @brief Finds the intervals containing each of a batch of points, interleaving one walk per point to hide memory latency.
+     *
+     * Nothing is sorted. Up to group walks are in flight at once and take
+     * turns advancing one node, each prefetching the nodes it visits next, so
+     * the cache misses of different points overlap instead of following one
+     * another. This suits scattered points on trees far larger than the
+     * cache, where the sorted sweep of Containing(points, count) gains little.
+     *
+     * @param points The query points, in any order.
+     * @param count The number of query points.
+     * @param group The number of walks in flight; about the number of cache misses a core can have outstanding.
+     * @return The hits of each point, in the order the points were given.
+     */
+    IntervalBatchResult<T, V> ContainingInterleaved(const T* points, size_t count, size_t group = 16) const;
 
-    void Insert(T low, T high, std::shared_ptr<T> data = nullptr); ///< Inserts a new interval into the tree.
-    void Insert(Interval<T> i, std::shared_ptr<T> data = nullptr); ///< Inserts a new interval into the tree.
-    void Remove(Interval<T> i); ///< Removes an interval from the tree.
-    void Update(Interval<T> oldInterval, Interval<T> newInterval, std::shared_ptr<T> newData = nullptr); ///< Updates an interval.
+    /**
+     * @brief Counts the intervals that overlap with a given range, without allocating.
+     *
+     * With a SubtreeCount or SubtreeAggregate policy, whole subtrees inside the
+     * query are counted from their summary; otherwise every hit is visited.
+     *
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return The number of overlapping intervals.
+     */
+    size_t CountOverlapping(T low, T high) const;
 
     /**
-     * @brief Finds all intervals that contain a specific value.
+     * @brief Counts the intervals that contain a specific value, without allocating.
      * @param value The value to check for containment.
-     * @return A vector of intervals that contain the specified value.
+     * @return The number of containing intervals.
      */
-    std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > Containing(T value) const;
+    size_t CountContaining(T value) const;
 
     /**
-     * @brief Finds all intervals that overlap with a given range.
+     * @brief Folds every interval that overlaps with a given range into a result, without allocating.
      * @param low The lower bound of the range.
      * @param high The upper bound of the range.
-     * @return A vector of intervals that overlap with the specified range.
+     * @param init The initial result.
+     * @param op The callable invoked as result = op(result, const Interval<T>&, const V&) for each hit.
+     * @return The folded result.
+     */
+    template <typename Result, typename Op>
+    Result Aggregate(T low, T high, Result init, Op op) const;
+
+    /**
+     * @brief Combines the monoid values of every interval that overlaps with a given range.
+     *
+     * Only available with a SubtreeAggregate policy. Whole subtrees inside the
+     * query contribute their stored summary, so a wide query stays about as
+     * cheap as a narrow one.
+     * Values are combined in ascending order of low, as in the stored
+     * summaries, so the monoid only has to be associative.
+     *
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return The combined value, or the monoid identity if nothing overlaps.
      */
-    std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > Overlapping(T low, T high) const;
+    template <typename Summary = A>
+    typename Summary::Value Aggregate(T low, T high) const;
 
     /**
      * @brief Finds the maximum high value of all intervals that overlap with a given range.
      * @param low The lower bound of the range.
      * @param high The upper bound of the range.
-     * @return The maximum high value of the intervals that overlap with the specified range.
+     * @return The maximum high value of the intervals that overlap with the specified range,
+     *         or IntervalKeyTraits<T>::Lowest() if there are none.
      */
 		T MaxHighOverlapping(T low, T high) const;
 
     /**
-     * @brief Finds all intervals within a specific minimum and maximum range.
+     * @brief Finds all intervals that reach into a specific minimum and maximum range.
+     *
+     * An interval matches when high >= min and low <= max, the same test as
+     * Overlapping(min, max), and the search is pruned the same way. Use Within
+     * for intervals that lie entirely inside the range.
+     *
+     * @param min The minimum value.
+     * @param max The maximum value.
+     * @return A vector of intervals that intersect the specified range.
+     */
+    std::vector<std::pair<Interval<T>, V> > FindByMinMax(T min, T max) const;
+
+    /**
+     * @brief Finds all intervals that lie entirely inside a range, with min <= low and high <= max.
+     *
+     * Subtrees whose max is below min, left subtrees under a node whose low is
+     * below min, and right subtrees under a node whose low is above max are
+     * never entered, so only nodes with low in [min, max] are examined.
+     *
+     * @param min The minimum value.
+     * @param max The maximum value.
+     * @return A vector of the intervals inside the range.
+     */
+    std::vector<std::pair<Interval<T>, V> > Within(T min, T max) const;
+
+    /**
+     * @brief Calls a visitor for every interval that lies entirely inside a range, without allocating.
      * @param min The minimum value.
      * @param max The maximum value.
-     * @return A vector of intervals that fall within the specified range.
+     * @param visit The callable invoked as visit(const Interval<T>&, const V&); returning false stops the query.
      */
-    std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > FindByMinMax(T min, T max) const;
+    template <typename Visitor>
+    void ForEachWithin(T min, T max, Visitor visit) const;
 
 
     /**
@@ -131,9 +1186,25 @@ class IntervalTree
 
     /**
      * @brief Clears the entire interval tree.
+     *
+     * Nodes are unlinked from an explicit stack rather than by the recursive
+     * std::shared_ptr destructors, and nodes a snapshot still shares are left
+     * to it. The work is still one deallocation per node; see ClearAsync().
      */
     void Clear(void);
 
+    /**
+     * @brief Empties the tree in O(1) and frees its nodes on a background thread.
+     *
+     * Payload destructors run on that thread. Like every future from
+     * std::async, the one returned waits for the teardown when it is
+     * destroyed, so keep it until waiting is harmless, for example until the
+     * next request.
+     *
+     * @return A future that becomes ready once the nodes are freed.
+     */
+    std::future<void> ClearAsync();
+
     /**
      * @brief Checks whether the tree is empty.
      * @return True if the tree is empty, false otherwise.
@@ -161,283 +1232,843 @@ class IntervalTree
      */
     size_t Size() const;
 
+    /**
+     * @brief Gets the height of the tree, which bounds the depth of every descent.
+     * @return The number of levels, 0 for an empty tree.
+     */
+    int Height() const
+    {
+      return Height(Root.get());
+    }
+
+    /**
+     * @brief Gets every interval in the tree.
+     * @return The intervals and their data in ascending order of low.
+     */
+    std::vector<std::pair<Interval<T>, V> > Intervals() const;
+
+    /**
+     * @brief Starts a walk over the intervals in ascending order of low without copying them out.
+     *
+     * The cursor keeps the current version alive, so it stays valid while the
+     * tree changes and does not see those changes.
+     *
+     * @return A cursor on the lowest node, or one that is already done for an empty tree.
+     */
+    IntervalTreeDetail::InOrderCursor<Node<T, V, A> > InOrder() const
+    {
+      return IntervalTreeDetail::InOrderCursor<Node<T, V, A> >(Root, Height());
+    }
+
+    typedef IntervalTreeDetail::CursorIterator<IntervalTreeDetail::InOrderCursor<Node<T, V, A> > > const_iterator; ///< Walks every node in ascending order of low.
+    typedef const_iterator iterator; ///< Nodes cannot be changed through an iterator.
+    typedef IntervalTreeDetail::CursorRange<IntervalTreeDetail::OverlapCursor<Node<T, V, A> > > OverlapRangeType; ///< The lazy result of OverlapRange.
+
+    /**
+     * @brief Gets an iterator on the node with the lowest low; *it exposes the interval and data members.
+     *
+     * Like InOrder(), the iterator keeps the current version alive and does
+     * not see later changes.
+     */
+    const_iterator begin() const
+    {
+      return const_iterator(InOrder());
+    }
+
+    /**
+     * @brief Gets the iterator past the last node.
+     */
+    const_iterator end() const
+    {
+      return const_iterator();
+    }
+
+    /**
+     * @brief Finds the intervals that overlap with a given range lazily, one node per increment.
+     *
+     * Unlike Overlapping(), nothing is copied and the walk stops as soon as
+     * the caller does, so taking the first few hits costs O(log n + k). The
+     * hits come in ascending order of low, ready to merge with another sorted
+     * stream, and the range holds only an O(height) stack and the version it
+     * started on.
+     *
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return A range of nodes whose interval and data members hold each hit.
+     */
+    OverlapRangeType OverlapRange(T low, T high) const
+    {
+      return OverlapRangeType(IntervalTreeDetail::OverlapCursor<Node<T, V, A> >(Root, Height(), low, high));
+    }
+
+    /**
+     * @brief Finds the intervals that contain a specific value lazily; see OverlapRange.
+     * @param value The value to check for containment.
+     * @return A range of nodes whose interval and data members hold each hit.
+     */
+    OverlapRangeType ContainingRange(T value) const
+    {
+      return OverlapRange(value, value);
+    }
+
+    /**
+     * @brief Gets the counters of the statistics policy and the depth and balance histograms of the tree.
+     *
+     * The histograms come from a walk over every node, O(n), so this is meant
+     * for periodic sampling rather than for every query.
+     *
+     * @return The statistics; the counters are zero under NoStats.
+     */
+    IntervalTreeStats Stats() const;
+
+    /**
+     * @brief Sets the counters of the statistics policy back to zero.
+     */
+    void ResetStats()
+    {
+      S::Reset();
+    }
+
   private:
-    std::shared_ptr<Node<T> > Root;  ///< The root of the interval tree.
+    std::shared_ptr<Node<T, V, A> > Root;  ///< The root of the interval tree.
     size_t size; ///< The number of intervals in the tree.
 
     /**
-     * @brief Helper function to insert an interval.
+     * @brief Copies the node held by slot if another tree version shares it, so it can be modified.
+     *
+     * The copy references the same children, which become shared in turn, so
+     * each level of a descent decides for itself.
+     */
+    static void Detach(std::shared_ptr<Node<T, V, A> >& slot);
+
+    /**
+     * @brief Helper function to insert an interval into the subtree held by slot, building its payload from args.
+     */
+    template <typename... Args>
+    void EmplaceAt(std::shared_ptr<Node<T, V, A> >& slot, const Interval<T>& i, Args&&... args);
+
+    /**
+     * @brief Records the path to a node holding exactly the given interval and a payload accepted by match.
+     *
+     * Intervals sharing a low bound may sit on either side of each other, so
+     * both subtrees are searched when the lows are equal; subtrees whose max
+     * stays below the interval's high are skipped.
+     *
+     * @param path Receives the nodes below the root on the path, the matching node first.
+     * @return True if a matching node was found.
+     */
+    template <typename Match>
+    bool Locate(const Node<T, V, A>* node, const Interval<T>& i, Match& match,
+      IntervalTreeDetail::NodeStack<const Node<T, V, A>*>& path) const;
+
+    /**
+     * @brief Follows a path recorded by Locate from the root, detaching every node on it.
+     * @param slots Receives the slot of each node on the path, the root's first, so the target's is on top.
+     */
+    void DetachPath(IntervalTreeDetail::NodeStack<const Node<T, V, A>*>& path,
+      IntervalTreeDetail::NodeStack<std::shared_ptr<Node<T, V, A> >*>& slots);
+
+    /**
+     * @brief Removes a node holding exactly the given interval and a payload accepted by match.
+     */
+    template <typename Match>
+    bool RemoveMatching(const Interval<T>& i, Match& match);
+
+    /**
+     * @brief Updates the cached maximum value, height and augmentation summary of the node from its children.
      */
-    std::shared_ptr<Node<T> > Insert(std::shared_ptr<Node<T> > node, Interval<T> i, std::shared_ptr<T> data);
+    void UpdateMax(Node<T, V, A>* node);
 
     /**
-     * @brief Helper function to remove an interval.
+     * @brief Visits intervals containing a specific value.
+     * @return False if the visitor stopped the query.
      */
-    std::shared_ptr<Node<T> > Remove(std::shared_ptr<Node<T> > node, Interval<T> i);
+    template <typename Visitor>
+    bool FindContaining(const Node<T, V, A>* node, T value, Visitor& visit) const;
 
     /**
-     * @brief Updates the maximum values in the subtree.
+     * @brief Visits overlapping intervals with a given range.
+     * @return False if the visitor stopped the query.
      */
-    void UpdateMax(std::shared_ptr<Node<T> > node);
+    template <typename Visitor>
+    bool FindOverlapping(const Node<T, V, A>* node, T low, T high, Visitor& visit) const;
 
     /**
-     * @brief UFinds the minimum node in the subtree.
+     * @brief Visits the overlapping intervals, handing whole subtrees that lie inside the query to whole().
+     *
+     * A subtree lies inside when all its lows are <= high, which the path
+     * bounds (lows left of an ancestor never exceed its low), and its
+     * minHigh is >= low. Other hits are passed to each() one node at a time.
+     * Both are called in ascending order of low.
      */
-    std::shared_ptr<Node<T> > FindMin(std::shared_ptr<Node<T> > node) const;
+    template <typename Whole, typename Each>
+    void FindSummarized(const Node<T, V, A>* node, T low, T high, Whole& whole, Each& each) const;
 
     /**
-     * @brief Finds intervals containing a specific value.
+     * @brief Counts overlapping intervals from the subtree counts of the policy.
      */
-    void FindContaining(std::shared_ptr<Node<T> > node, T value,
-      std::vector<std::pair<Interval<T>, std::shared_ptr<T> > >& result) const;
+    size_t CountOverlapping(T low, T high, std::true_type) const;
 
     /**
-     * @brief Finds overlapping intervals with a given range.
+     * @brief Counts overlapping intervals by visiting each one.
      */
-    void FindOverlapping(std::shared_ptr<Node<T> > node, T low, T high,
-      std::vector<std::pair<Interval<T>, std::shared_ptr<T> > >& result) const;
+    size_t CountOverlapping(T low, T high, std::false_type) const;
 
     /**
      * @brief Finds the max high value of the overlapping intervals with a given range.
      */
-    void MaxHighOverlapping(std::shared_ptr<Node<T>> node, T low, T high, T& maxValue) const;
+    void MaxHighOverlapping(const Node<T, V, A>* node, T low, T high, T& maxValue) const;
 
     /**
-     * @brief Finds intervals within a specific range.
+     * @brief Visits intervals that lie entirely inside a range.
+     * @return False if the visitor stopped the query.
      */
-    void FindByMinMax(std::shared_ptr<Node<T> > node, T min, T max,
-      std::vector<std::pair<Interval<T>, std::shared_ptr<T> > >& result) const;
+    template <typename Visitor>
+    bool FindWithin(const Node<T, V, A>* node, T min, T max, Visitor& visit) const;
 
     /**
      * @brief Checks if a value is contained in the tree.
      */
-    bool Contains(std::shared_ptr<Node<T>> node, T value) const;
+    bool Contains(const Node<T, V, A>* node, T value) const;
 
     /**
      * @brief Checks for overlaps in the tree.
      */
-    bool Overlaps(std::shared_ptr<Node<T>> node, T low, T high) const;
+    bool Overlaps(const Node<T, V, A>* node, T low, T high) const;
+
+    /**
+     * @brief Returns the cached height of the subtree rooted at the given node.
+     */
+    int Height(const Node<T, V, A>* node) const;
 
     /**
-     * @brief Calculates the height of the subtree rooted at the given node.
+     * @brief Drops a reference to a subtree, freeing the nodes it alone owns with an explicit stack.
      */
-    int Height(std::shared_ptr<Node<T>> node) const;
+    static void Release(std::shared_ptr<Node<T, V, A> > node);
 
     /**
      * @brief Calculates the balance factor of the given node.
      */
-    int GetBalance(std::shared_ptr<Node<T>> node) const;
+    int GetBalance(const Node<T, V, A>* node) const;
+
+    /**
+     * @brief Restores the AVL balance of the detached node held by slot.
+     */
+    void Rebalance(std::shared_ptr<Node<T, V, A> >& slot);
+
+    /**
+     * @brief Performs a right rotation on the node held by slot.
+     */
+    void RotateRight(std::shared_ptr<Node<T, V, A> >& slot);
+
+    /**
+     * @brief Performs a left rotation on the node held by slot.
+     */
+    void RotateLeft(std::shared_ptr<Node<T, V, A> >& slot);
+
+    /**
+     * @brief Appends the intervals of the subtree to the vector in ascending order of low.
+     */
+    void CollectInOrder(const Node<T, V, A>* node,
+      std::vector<std::pair<Interval<T>, V> >& result) const;
+
+    /**
+     * @brief Builds a perfectly balanced subtree from entries sorted by low, moving their payloads into the nodes.
+     */
+    std::shared_ptr<Node<T, V, A> > Build(std::vector<std::pair<Interval<T>, V> >& entries,
+      size_t begin, size_t end);
+
+    /**
+     * @brief Stable-sorts entries by low, optionally splitting the work across threads.
+     */
+    static void SortByLow(std::vector<std::pair<Interval<T>, V> >& entries, bool parallel);
+
+    /**
+     * @brief Exposes the nodes to IntervalTreeDetail::InterleavedContaining.
+     */
+    struct NodeWalk
+    {
+      typedef const Node<T, V, A>* Ref;
+
+      Ref root; ///< The root of the walked tree.
+      int height; ///< The height of root.
+
+      Ref Root() const { return root; }
+      int Depth() const { return height; }
+      static bool Valid(Ref node) { return node != nullptr; }
+      static void Prefetch(Ref node) { IntervalTreeDetail::Prefetch(&node->interval); }
+      static const T& Low(Ref node) { return node->interval.low; }
+      static const T& High(Ref node) { return node->interval.high; }
+      static const T& Max(Ref node) { return node->max; }
+      static Ref Left(Ref node) { return node->left.get(); }
+      static Ref Right(Ref node) { return node->right.get(); }
+    };
 
     /**
-     * @brief Performs a right rotation on the given node.
+     * @brief Answers a batch of queries sorted by low and gathers the hits in CSR form.
      */
-    std::shared_ptr<Node<T>> RotateRight(std::shared_ptr<Node<T>> node);
+    void FindBatch(std::vector<IntervalTreeDetail::BatchQuery<T> >& queries, bool points,
+      IntervalBatchResult<T, V>& result) const;
 
     /**
-     * @brief Performs a left rotation on the given node.
+     * @brief Converts a bulk-load element to a tree entry.
      */
-    std::shared_ptr<Node<T>> RotateLeft(std::shared_ptr<Node<T>> node);
+    static std::pair<Interval<T>, V> MakeEntry(const Interval<T>& i)
+    {
+      return std::make_pair(i, V());
+    }
 
-    void ToString(std::shared_ptr<Node<T>> node, std::ostringstream& oss) const;
+    /**
+     * @brief Converts a bulk-load element to a tree entry.
+     */
+    static std::pair<Interval<T>, V> MakeEntry(const std::pair<Interval<T>, V>& entry)
+    {
+      return entry;
+    }
 };
 
 
-template <typename T>
-void IntervalTree<T>::Insert(T low, T high, std::shared_ptr<T> data)
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::Insert(T low, T high, V data)
 {
   Interval<T> i(low, high);
-  Insert(i, data);
+  Insert(i, std::move(data));
 }
 
-template <typename T>
-void IntervalTree<T>::Insert(Interval<T> i, std::shared_ptr<T> data)
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::Insert(Interval<T> i, V data)
 {
   if(i.low > i.high)
   {
     throw std::invalid_argument("Invalid interval: low must be less than or equal to high.");
   }
-  Root = Insert(Root, i, data);
+  EmplaceAt(Root, i, std::move(data));
   size++; // Increment size on successful insertion
 }
 
-template <typename T>
-void IntervalTree<T>::Remove(Interval<T> i)
+template <typename T, typename V, typename A, typename S>
+bool IntervalTree<T, V, A, S>::Remove(Interval<T> i)
+{
+  auto any = [](const V&) { return true; };
+  return RemoveMatching(i, any);
+}
+
+template <typename T, typename V, typename A, typename S>
+bool IntervalTree<T, V, A, S>::Remove(Interval<T> i, const V& data)
+{
+  auto same = [&data](const V& candidate) { return candidate == data; };
+  return RemoveMatching(i, same);
+}
+
+template <typename T, typename V, typename A, typename S>
+template <typename... Args>
+void IntervalTree<T, V, A, S>::Emplace(T low, T high, Args&&... args)
+{
+  if(low > high)
+  {
+    throw std::invalid_argument("Invalid interval: low must be less than or equal to high.");
+  }
+  EmplaceAt(Root, Interval<T>(low, high), std::forward<Args>(args)...);
+  size++;
+}
+
+template <typename T, typename V, typename A, typename S>
+bool IntervalTree<T, V, A, S>::Update(Interval<T> oldInterval, Interval<T> newInterval, V newData)
+{
+  if(newInterval.low > newInterval.high)
+  {
+    throw std::invalid_argument("Invalid interval: low must be less than or equal to high.");
+  }
+  if(oldInterval.low != newInterval.low)
+  {
+    bool found = Remove(oldInterval);
+    Insert(newInterval, std::move(newData));
+    return found;
+  }
+
+  auto any = [](const V&) { return true; };
+  IntervalTreeDetail::NodeStack<const Node<T, V, A>*> path(Height(Root.get()));
+  if(!Locate(Root.get(), oldInterval, any, path))
+  {
+    Insert(newInterval, std::move(newData));
+    return false;
+  }
+
+  // The low bound is unchanged, so the node keeps its place; only the maxima above it can change
+  IntervalTreeDetail::NodeStack<std::shared_ptr<Node<T, V, A> >*> slots(Height(Root.get()));
+  DetachPath(path, slots);
+  Node<T, V, A>* node = slots.Pop()->get();
+  node->data = std::move(newData);
+  if(node->interval.high != newInterval.high)
+  {
+    node->interval.high = newInterval.high;
+    UpdateMax(node);
+    while(!slots.IsEmpty())
+    {
+      UpdateMax(slots.Pop()->get());
+    }
+  }
+  return true;
+}
+
+template <typename T, typename V, typename A, typename S>
+template <typename Iter>
+void IntervalTree<T, V, A, S>::BulkInsert(Iter first, Iter last, bool parallel)
 {
-    if(Contains(i.low)) // Optional: Check if interval exists before removing
+  std::vector<std::pair<Interval<T>, V> > entries;
+  for(; first != last; ++first)
+  {
+    entries.push_back(MakeEntry(*first));
+    if(entries.back().first.low > entries.back().first.high)
     {
-        Root = Remove(Root, i);
-        size--; // Decrement size on successful removal
+      throw std::invalid_argument("Invalid interval: low must be less than or equal to high.");
     }
+  }
+  if(entries.empty())
+  {
+    return;
+  }
+  SortByLow(entries, parallel);
+
+  if(Root)
+  {
+    // The existing intervals come out already sorted, so a stable merge keeps them ahead of equal new lows
+    std::vector<std::pair<Interval<T>, V> > existing;
+    existing.reserve(size);
+    CollectInOrder(Root.get(), existing);
+
+    std::vector<std::pair<Interval<T>, V> > merged;
+    merged.reserve(existing.size() + entries.size());
+    std::merge(existing.begin(), existing.end(), entries.begin(), entries.end(), std::back_inserter(merged),
+      [](const std::pair<Interval<T>, V>& a, const std::pair<Interval<T>, V>& b)
+      {
+        return a.first.low < b.first.low;
+      });
+    entries.swap(merged);
+  }
+
+  std::shared_ptr<Node<T, V, A> > old = std::move(Root);
+  Root = Build(entries, 0, entries.size());
+  size = entries.size();
+  Release(std::move(old)); // The entries hold copies, so the old nodes can go without recursive destructors
+}
+
+template <typename T, typename V, typename A, typename S>
+std::vector<std::pair<Interval<T>, V> > IntervalTree<T, V, A, S>::Containing(T value) const
+{
+  std::vector<std::pair<Interval<T>, V> > result;
+  Containing(value, result);
+  return result;
+}
+
+template <typename T, typename V, typename A, typename S>
+std::vector<std::pair<Interval<T>, V> > IntervalTree<T, V, A, S>::Overlapping(T low, T high) const
+{
+  std::vector<std::pair<Interval<T>, V> > result;
+  Overlapping(low, high, result);
+  return result;
+}
+
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::Containing(T value, std::vector<std::pair<Interval<T>, V> >& result) const
+{
+  result.clear();
+  CopyContaining(value, std::back_inserter(result));
+}
+
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::Overlapping(T low, T high, std::vector<std::pair<Interval<T>, V> >& result) const
+{
+  result.clear();
+  CopyOverlapping(low, high, std::back_inserter(result));
+}
+
+template <typename T, typename V, typename A, typename S>
+template <typename Visitor>
+void IntervalTree<T, V, A, S>::ForEachContaining(T value, Visitor visit) const
+{
+  FindContaining(Root.get(), value, visit);
+}
+
+template <typename T, typename V, typename A, typename S>
+template <typename Visitor>
+void IntervalTree<T, V, A, S>::ForEachOverlapping(T low, T high, Visitor visit) const
+{
+  FindOverlapping(Root.get(), low, high, visit);
+}
+
+template <typename T, typename V, typename A, typename S>
+template <typename OutputIt>
+OutputIt IntervalTree<T, V, A, S>::CopyContaining(T value, OutputIt out) const
+{
+  ForEachContaining(value, [&out](const Interval<T>& i, const V& data)
+  {
+    *out = std::make_pair(i, data);
+    ++out;
+  });
+  return out;
+}
+
+template <typename T, typename V, typename A, typename S>
+template <typename OutputIt>
+OutputIt IntervalTree<T, V, A, S>::CopyOverlapping(T low, T high, OutputIt out) const
+{
+  ForEachOverlapping(low, high, [&out](const Interval<T>& i, const V& data)
+  {
+    *out = std::make_pair(i, data);
+    ++out;
+  });
+  return out;
+}
+
+template <typename T, typename V, typename A, typename S>
+IntervalBatchResult<T, V> IntervalTree<T, V, A, S>::Containing(const T* points, size_t count) const
+{
+  std::vector<IntervalTreeDetail::BatchQuery<T> > queries(count);
+  for(size_t q = 0; q < count; ++q)
+  {
+    queries[q].low = points[q];
+    queries[q].high = points[q];
+    queries[q].index = q;
+  }
+
+  IntervalBatchResult<T, V> result;
+  FindBatch(queries, true, result);
+  return result;
+}
+
+template <typename T, typename V, typename A, typename S>
+IntervalBatchResult<T, V> IntervalTree<T, V, A, S>::Overlapping(const Interval<T>* ranges, size_t count) const
+{
+  std::vector<IntervalTreeDetail::BatchQuery<T> > queries(count);
+  for(size_t q = 0; q < count; ++q)
+  {
+    queries[q].low = ranges[q].low;
+    queries[q].high = ranges[q].high;
+    queries[q].index = q;
+  }
+
+  IntervalBatchResult<T, V> result;
+  FindBatch(queries, false, result);
+  return result;
+}
+
+template <typename T, typename V, typename A, typename S>
+IntervalBatchResult<T, V> IntervalTree<T, V, A, S>::ContainingInterleaved(const T* points, size_t count, size_t group) const
+{
+  const NodeWalk walk = { Root.get(), Height(Root.get()) };
+  std::vector<std::pair<size_t, const Node<T, V, A>*> > found;
+  IntervalTreeDetail::InterleavedContaining(walk, points, count, group, found);
+
+  IntervalBatchResult<T, V> result;
+  IntervalTreeDetail::GatherBatch(found, count, result,
+    [](const Node<T, V, A>* hit) { return std::make_pair(hit->interval, hit->data); });
+  return result;
+}
+
+template <typename T, typename V, typename A, typename S>
+size_t IntervalTree<T, V, A, S>::CountOverlapping(T low, T high) const
+{
+  return CountOverlapping(low, high, typename std::is_base_of<SubtreeCount<T>, A>::type());
+}
+
+template <typename T, typename V, typename A, typename S>
+size_t IntervalTree<T, V, A, S>::CountContaining(T value) const
+{
+  return CountOverlapping(value, value);
+}
+
+template <typename T, typename V, typename A, typename S>
+template <typename Result, typename Op>
+Result IntervalTree<T, V, A, S>::Aggregate(T low, T high, Result init, Op op) const
+{
+  auto fold = [&init, &op](const Interval<T>& i, const V& data)
+  {
+    init = op(init, i, data);
+  };
+  FindOverlapping(Root.get(), low, high, fold);
+  return init;
+}
+
+template <typename T, typename V, typename A, typename S>
+template <typename Summary>
+typename Summary::Value IntervalTree<T, V, A, S>::Aggregate(T low, T high) const
+{
+  typename Summary::Value value = Summary::Identity();
+  auto whole = [&value](const A& subtree)
+  {
+    value = Summary::Combine(value, subtree.value);
+  };
+  auto each = [&value](const Interval<T>& i)
+  {
+    value = Summary::Combine(value, Summary::Of(i));
+  };
+  FindSummarized(Root.get(), low, high, whole, each);
+  return value;
 }
 
-template <typename T>
-void IntervalTree<T>::Update(Interval<T> oldInterval, Interval<T> newInterval, std::shared_ptr<T> newData)
+template <typename T, typename V, typename A, typename S>
+T IntervalTree<T, V, A, S>::MaxHighOverlapping(T low, T high) const
 {
-  Remove(oldInterval);
-  Insert(newInterval, newData);
+  T maxValue = IntervalKeyTraits<T>::Lowest();  // numeric_limits<T>::min() is the smallest positive value for floating point
+  MaxHighOverlapping(Root.get(), low, high, maxValue);   // Call the helper function to compute the max value.
+  return maxValue;
 }
 
-template <typename T>
-std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > IntervalTree<T>::Containing(T value) const
+template <typename T, typename V, typename A, typename S>
+std::vector<std::pair<Interval<T>, V> > IntervalTree<T, V, A, S>::FindByMinMax(T min, T max) const
 {
-  std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > result;
-  FindContaining(Root, value, result);
-  return result;
+  return Overlapping(min, max);
 }
 
-template <typename T>
-std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > IntervalTree<T>::Overlapping(T low, T high) const
+template <typename T, typename V, typename A, typename S>
+std::vector<std::pair<Interval<T>, V> > IntervalTree<T, V, A, S>::Within(T min, T max) const
 {
-  std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > result;
-  FindOverlapping(Root, low, high, result);
+  std::vector<std::pair<Interval<T>, V> > result;
+  ForEachWithin(min, max, [&result](const Interval<T>& i, const V& data)
+  {
+    result.emplace_back(i, data);
+  });
   return result;
 }
 
-template <typename T>
-T IntervalTree<T>::MaxHighOverlapping(T low, T high) const
+template <typename T, typename V, typename A, typename S>
+template <typename Visitor>
+void IntervalTree<T, V, A, S>::ForEachWithin(T min, T max, Visitor visit) const
 {
-  T maxValue = std::numeric_limits<T>::min();  // Initialize to the smallest possible value of type T.
-  MaxHighOverlapping(Root, low, high, maxValue);   // Call the helper function to compute the max value.
-  return maxValue;
+  FindWithin(Root.get(), min, max, visit);
 }
 
-template <typename T>
-std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > IntervalTree<T>::FindByMinMax(T min, T max) const
+template <typename T, typename V, typename A, typename S>
+bool IntervalTree<T, V, A, S>::Contains(T value) const
 {
-  std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > result;
-  FindByMinMax(Root, min, max, result);
-  return result;
+  return Contains(Root.get(), value);
 }
 
-template <typename T>
-bool IntervalTree<T>::Contains(T value) const
+template <typename T, typename V, typename A, typename S>
+bool IntervalTree<T, V, A, S>::Overlaps(T low, T high) const
 {
-  return Contains(Root, value);
+  return Overlaps(Root.get(), low, high);
 }
 
-template <typename T>
-bool IntervalTree<T>::Overlaps(T low, T high) const
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::Clear()
 {
-  return Overlaps(Root, low, high);
+  Release(std::move(Root));
+  size = 0;
 }
 
-template <typename T>
-void IntervalTree<T>::Clear()
+template <typename T, typename V, typename A, typename S>
+std::future<void> IntervalTree<T, V, A, S>::ClearAsync()
 {
-  Root = nullptr; // Setting the root to nullptr will clear the entire tree.
   size = 0;
+  return std::async(std::launch::async, &IntervalTree<T, V, A, S>::Release, std::move(Root));
 }
 
-template <typename T>
-size_t IntervalTree<T>::Size() const
+template <typename T, typename V, typename A, typename S>
+size_t IntervalTree<T, V, A, S>::Size() const
 {
   return size; // Return the current size of the tree
 }
 
-template <typename T>
-bool IntervalTree<T>::IsEmpty() const
+template <typename T, typename V, typename A, typename S>
+std::vector<std::pair<Interval<T>, V> > IntervalTree<T, V, A, S>::Intervals() const
+{
+  std::vector<std::pair<Interval<T>, V> > result;
+  result.reserve(size);
+  CollectInOrder(Root.get(), result);
+  return result;
+}
+
+template <typename T, typename V, typename A, typename S>
+IntervalTreeStats IntervalTree<T, V, A, S>::Stats() const
+{
+  IntervalTreeStats stats;
+  S::Read(stats);
+  stats.depths.resize(Height());
+
+  IntervalTreeDetail::NodeStack<std::pair<const Node<T, V, A>*, int> > stack(Height());
+  if(Root)
+  {
+    stack.Push(std::make_pair(Root.get(), 0));
+  }
+  while(!stack.IsEmpty())
+  {
+    std::pair<const Node<T, V, A>*, int> entry = stack.Pop();
+    const Node<T, V, A>* node = entry.first;
+    stats.depths[entry.second]++;
+    stats.balances[std::max(-1, std::min(1, GetBalance(node))) + 1]++; // AVL keeps the factor within [-1, 1]; a broken tree still lands at an end
+    if(node->right)
+    {
+      stack.Push(std::make_pair(node->right.get(), entry.second + 1));
+    }
+    if(node->left)
+    {
+      stack.Push(std::make_pair(node->left.get(), entry.second + 1));
+    }
+  }
+  return stats;
+}
+
+template <typename T, typename V, typename A, typename S>
+bool IntervalTree<T, V, A, S>::IsEmpty() const
 {
   return Root == nullptr;
 }
 
-template <typename T>
-std::string IntervalTree<T>::ToString() const
+template <typename T, typename V, typename A, typename S>
+std::string IntervalTree<T, V, A, S>::ToString() const
 {
   std::ostringstream oss;
-  // In-order traversal to print intervals
-  ToString(Root, oss);
+  for(const Node<T, V, A>& node : *this)
+  {
+    oss << "[" << node.interval.low << ", " << node.interval.high << "] ";
+  }
   return oss.str();
 }
 
-template <typename T>
-std::shared_ptr<Node<T> > IntervalTree<T>::Insert(std::shared_ptr<Node<T> > node, Interval<T> i, std::shared_ptr<T> data)
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::Detach(std::shared_ptr<Node<T, V, A> >& slot)
+{
+  if(slot.use_count() > 1)
+  {
+    slot = std::make_shared<Node<T, V, A> >(*slot); // Path copy: the other version keeps the original
+  }
+  else
+  {
+    // use_count() is a relaxed load; the fence orders it after the release that dropped the last other
+    // reference, so that thread's reads of the node happen before the writes made in place here
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+}
+
+template <typename T, typename V, typename A, typename S>
+template <typename... Args>
+void IntervalTree<T, V, A, S>::EmplaceAt(std::shared_ptr<Node<T, V, A> >& slot, const Interval<T>& i, Args&&... args)
 {
-  if(node == nullptr)
+  if(slot == nullptr)
   {
-    return std::make_shared<Node<T> >(i, data);
+    slot = std::make_shared<Node<T, V, A> >(i, std::forward<Args>(args)...); // Forwarded only once, into the new leaf
+    return;
   }
 
-  if(i.low < node->interval.low)
+  Detach(slot);
+  if(i.low < slot->interval.low)
   {
-    node->left = Insert(node->left, i, data);
+    EmplaceAt(slot->left, i, std::forward<Args>(args)...);
   }
   else
   {
-    node->right = Insert(node->right, i, data);
+    EmplaceAt(slot->right, i, std::forward<Args>(args)...);
   }
+  Rebalance(slot);
+}
 
-  UpdateMax(node);
+template <typename T, typename V, typename A, typename S>
+template <typename Match>
+bool IntervalTree<T, V, A, S>::Locate(const Node<T, V, A>* node, const Interval<T>& i, Match& match,
+  IntervalTreeDetail::NodeStack<const Node<T, V, A>*>& path) const
+{
+  if(node == nullptr || node->max < i.high)
+  {
+    return false;
+  }
 
-  // Check for balance and perform rotations if needed
-  int balance = GetBalance(node);
-  if(balance > 1)
+  if(i.low < node->interval.low)
   {
-    if(i.low < node->left->interval.low)
-    {
-      return RotateRight(node);
-    }
-    else
+    if(Locate(node->left.get(), i, match, path))
     {
-      node->left = RotateLeft(node->left);
-      return RotateRight(node);
+      path.Push(node->left.get());
+      return true;
     }
+    return false;
   }
-  if(balance < -1)
+  if(i.low == node->interval.low)
   {
-    if(i.low > node->right->interval.low)
+    if(i.high == node->interval.high && match(node->data))
     {
-      return RotateLeft(node);
+      return true;
     }
-    else
+    if(Locate(node->left.get(), i, match, path))
     {
-      node->right = RotateRight(node->right);
-      return RotateLeft(node);
+      path.Push(node->left.get());
+      return true;
     }
   }
-  return node;
+  if(Locate(node->right.get(), i, match, path))
+  {
+    path.Push(node->right.get());
+    return true;
+  }
+  return false;
 }
 
-template <typename T>
-std::shared_ptr<Node<T> > IntervalTree<T>::Remove(std::shared_ptr<Node<T> > node, Interval<T> i)
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::DetachPath(IntervalTreeDetail::NodeStack<const Node<T, V, A>*>& path,
+  IntervalTreeDetail::NodeStack<std::shared_ptr<Node<T, V, A> >*>& slots)
 {
-  if(node == nullptr)
+  std::shared_ptr<Node<T, V, A> >* slot = &Root;
+  Detach(*slot);
+  slots.Push(slot);
+  while(!path.IsEmpty())
   {
-    return nullptr;
+    // A detached copy still points at the original children, so the recorded nodes pick the side
+    const Node<T, V, A>* next = path.Pop();
+    slot = (*slot)->left.get() == next ? &(*slot)->left : &(*slot)->right;
+    Detach(*slot);
+    slots.Push(slot);
   }
+}
 
-  if(i.low < node->interval.low)
+template <typename T, typename V, typename A, typename S>
+template <typename Match>
+bool IntervalTree<T, V, A, S>::RemoveMatching(const Interval<T>& i, Match& match)
+{
+  IntervalTreeDetail::NodeStack<const Node<T, V, A>*> path(Height(Root.get()));
+  if(!Locate(Root.get(), i, match, path))
   {
-    node->left = Remove(node->left, i);
+    return false;
   }
-  else if(i.low > node->interval.low)
+
+  // The target and, below it, the successor lie on one root-to-leaf path, so height + 1 slots suffice
+  IntervalTreeDetail::NodeStack<std::shared_ptr<Node<T, V, A> >*> slots(Height(Root.get()));
+  DetachPath(path, slots);
+  std::shared_ptr<Node<T, V, A> >* target = slots.Pop();
+  Node<T, V, A>* node = target->get();
+
+  if(node->left == nullptr || node->right == nullptr)
   {
-    node->right = Remove(node->right, i);
+    // The remaining child is balanced and possibly shared with a snapshot, so it is linked in untouched
+    *target = std::move(node->left ? node->left : node->right);
   }
   else
   {
-    // Node with the interval found
-    if(node->left == nullptr)
-    {
-      return node->right;
-    }
-    else if(node->right == nullptr)
+    // Node with two children: the in-order successor (smallest in the right subtree) takes its place
+    slots.Push(target);
+    std::shared_ptr<Node<T, V, A> >* slot = &node->right;
+    Detach(*slot);
+    while((*slot)->left)
     {
-      return node->left;
+      slots.Push(slot);
+      slot = &(*slot)->left;
+      Detach(*slot);
     }
-
-    // Node with two children: Get the inorder successor (smallest in the right subtree)
-    std::shared_ptr<Node<T> > minNode = FindMin(node->right);
-    node->interval = minNode->interval;
-    node->data = minNode->data;
-    node->right = Remove(node->right, minNode->interval);
+    node->interval = (*slot)->interval;
+    node->data = std::move((*slot)->data);
+    *slot = std::move((*slot)->right);
   }
 
-  UpdateMax(node);
-  return node;
+  // Every slot left on the stack holds a detached node, rebalanced deepest first like Insert does
+  while(!slots.IsEmpty())
+  {
+    Rebalance(*slots.Pop());
+  }
+  size--;
+  return true;
 }
 
-template <typename T>
-void IntervalTree<T>::UpdateMax(std::shared_ptr<Node<T> > node)
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::UpdateMax(Node<T, V, A>* node)
 {
   if(node)
   {
@@ -450,211 +2081,571 @@ void IntervalTree<T>::UpdateMax(std::shared_ptr<Node<T> > node)
     {
       node->max = std::max(node->max, node->right->max);
     }
+    node->height = 1 + std::max(Height(node->left.get()), Height(node->right.get()));
+    node->Recompute(node->interval, static_cast<const A*>(node->left.get()), static_cast<const A*>(node->right.get()));
   }
 }
 
-template <typename T>
-std::shared_ptr<Node<T> > IntervalTree<T>::FindMin(std::shared_ptr<Node<T> > node) const
+template <typename T, typename V, typename A, typename S>
+template <typename Visitor>
+bool IntervalTree<T, V, A, S>::FindContaining(const Node<T, V, A>* node, T value, Visitor& visit) const
 {
-  while(node && node->left)
-  {
-    node = node->left;
-  }
-  return node;
+  return FindOverlapping(node, value, value, visit);
 }
 
-template <typename T>
-void IntervalTree<T>::FindContaining(std::shared_ptr<Node<T>> node, T value,
-  std::vector<std::pair<Interval<T>, std::shared_ptr<T>>>& result) const
+template <typename T, typename V, typename A, typename S>
+template <typename Visitor>
+bool IntervalTree<T, V, A, S>::FindOverlapping(const Node<T, V, A>* node, T low, T high, Visitor& visit) const
 {
-  if(node == nullptr)
+  IntervalTreeDetail::NodeStack<const Node<T, V, A>*> stack(Height(node));
+  typename S::Tally tally;
+  if(node)
   {
-    return;
+    stack.Push(node);
   }
 
-  // Check if the current node's interval contains the value
-  if(node->interval.low <= value && node->interval.high >= value)
+  while(!stack.IsEmpty())
   {
-    result.emplace_back(node->interval, node->data);
-  }
+    node = stack.Pop();
+    tally.Visited();
+    if(node->max < low)
+    {
+      tally.Pruned();
+      continue; // Nothing in this subtree reaches the query
+    }
 
-  // Traverse the left subtree if it might contain intervals
-  if(node->left && node->left->max >= value)
-  {
-    FindContaining(node->left, value, result);
-  }
+    if(node->interval.low <= high)
+    {
+      if(node->interval.high >= low)
+      {
+        tally.Reported();
+        if(!IntervalTreeDetail::Visit(visit, node->interval, node->data))
+        {
+          S::Record(tally);
+          return false;
+        }
+      }
+
+      // Lows in the right subtree are at least node->interval.low, so it can only overlap if that is still <= high
+      if(node->right)
+      {
+        stack.Push(node->right.get());
+      }
+    }
 
-  // Always traverse the right subtree
-  FindContaining(node->right, value, result);
+    // Pushed last so the left subtree is visited first
+    if(node->left)
+    {
+      stack.Push(node->left.get());
+    }
+  }
+  S::Record(tally);
+  return true;
 }
 
-template <typename T>
-void IntervalTree<T>::FindOverlapping(std::shared_ptr<Node<T> > node, T low, T high,
-  std::vector<std::pair<Interval<T>, std::shared_ptr<T> > >& result) const
+template <typename T, typename V, typename A, typename S>
+template <typename Whole, typename Each>
+void IntervalTree<T, V, A, S>::FindSummarized(const Node<T, V, A>* node, T low, T high, Whole& whole, Each& each) const
 {
-  if(node == nullptr)
+  // An entry is either a subtree to expand, with the low that bounds every low in it from above (null at the
+  // root), or a node whose own interval is due; a node goes back on the stack between its right and left
+  // subtrees, so hits come out in order of low, the order SubtreeAggregate combines a subtree in
+  struct Pending
   {
-    return;
-  }
-
-  if(node->interval.low <= high && node->interval.high >= low)
+    const Node<T, V, A>* node;
+    const T* bound;
+    bool report;
+  };
+  IntervalTreeDetail::NodeStack<Pending> stack(2 * Height(node)); // Up to a right subtree and a node per level
+  typename S::Tally tally;
+  if(node)
   {
-    result.emplace_back(node->interval, node->data);
+    stack.Push(Pending{node, nullptr, false});
   }
 
-  if(node->left && node->left->max >= low)
+  while(!stack.IsEmpty())
   {
-    FindOverlapping(node->left, low, high, result);
-  }
+    Pending entry = stack.Pop();
+    node = entry.node;
+    if(entry.report)
+    {
+      tally.Reported();
+      each(node->interval);
+      continue;
+    }
+    tally.Visited();
+    if(node->max < low)
+    {
+      tally.Pruned();
+      continue; // Nothing in this subtree reaches the query
+    }
+    if(entry.bound && *entry.bound <= high && node->minHigh >= low)
+    {
+      whole(static_cast<const A&>(*node)); // Every interval below overlaps
+      continue;
+    }
 
-  FindOverlapping(node->right, low, high, result);
+    if(node->interval.low <= high)
+    {
+      if(node->right)
+      {
+        stack.Push(Pending{node->right.get(), entry.bound, false});
+      }
+      if(node->interval.high >= low)
+      {
+        stack.Push(Pending{node, nullptr, true});
+      }
+    }
+    if(node->left)
+    {
+      stack.Push(Pending{node->left.get(), &node->interval.low, false});
+    }
+  }
+  S::Record(tally);
 }
 
-template <typename T>
-void IntervalTree<T>::MaxHighOverlapping(std::shared_ptr<Node<T>> node, T low, T high, T& maxValue) const
+template <typename T, typename V, typename A, typename S>
+size_t IntervalTree<T, V, A, S>::CountOverlapping(T low, T high, std::true_type) const
 {
-  if (node == nullptr)
+  size_t count = 0;
+  auto whole = [&count](const A& subtree)
   {
-    return;
-  }
-
-  // Check if the current node's interval overlaps with the given range.
-  if (node->interval.low <= high && node->interval.high >= low)
+    count += subtree.count;
+  };
+  auto each = [&count](const Interval<T>&)
   {
-    // If it overlaps, update the max value with the "high" value of the current node's interval.
-    maxValue = std::max(maxValue, node->interval.high);
-  }
+    ++count;
+  };
+  FindSummarized(Root.get(), low, high, whole, each);
+  return count;
+}
 
-  // Prune the search based on the maximum value of the left child (if any).
-  if (node->left && node->left->max >= low)
+template <typename T, typename V, typename A, typename S>
+size_t IntervalTree<T, V, A, S>::CountOverlapping(T low, T high, std::false_type) const
+{
+  size_t count = 0;
+  auto each = [&count](const Interval<T>&, const V&)
   {
-    MaxHighOverlapping(node->left, low, high, maxValue);  // Check the left subtree.
-  }
+    ++count;
+  };
+  FindOverlapping(Root.get(), low, high, each);
+  return count;
+}
 
-  // Always check the right subtree (since overlapping intervals can be in both directions).
-  MaxHighOverlapping(node->right, low, high, maxValue);
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::MaxHighOverlapping(const Node<T, V, A>* node, T low, T high, T& maxValue) const
+{
+  auto raise = [&maxValue](const Interval<T>& i, const V&)
+  {
+    maxValue = std::max(maxValue, i.high);
+  };
+  FindOverlapping(node, low, high, raise);
 }
 
-template <typename T>
-void IntervalTree<T>::FindByMinMax(std::shared_ptr<Node<T> > node, T min, T max,
-  std::vector<std::pair<Interval<T>, std::shared_ptr<T> > >& result) const
+template <typename T, typename V, typename A, typename S>
+template <typename Visitor>
+bool IntervalTree<T, V, A, S>::FindWithin(const Node<T, V, A>* node, T min, T max, Visitor& visit) const
 {
-  if(node == nullptr)
+  IntervalTreeDetail::NodeStack<const Node<T, V, A>*> stack(Height(node));
+  typename S::Tally tally;
+  if(node)
   {
-    return;
+    stack.Push(node);
   }
 
-  if(node->interval.high >= min && node->interval.low <= max)
+  while(!stack.IsEmpty())
   {
-    result.emplace_back(node->interval, node->data);
+    node = stack.Pop();
+    tally.Visited();
+    if(node->max < min)
+    {
+      tally.Pruned();
+      continue; // Every high in this subtree is below the range, so no low can be inside it
+    }
+
+    if(node->interval.low >= min && node->interval.high <= max)
+    {
+      tally.Reported();
+      if(!IntervalTreeDetail::Visit(visit, node->interval, node->data))
+      {
+        S::Record(tally);
+        return false;
+      }
+    }
+
+    // Right lows are >= node->interval.low and left lows are <= it, which bounds each side by the range
+    if(node->right && node->interval.low <= max)
+    {
+      stack.Push(node->right.get());
+    }
+    if(node->left && node->interval.low >= min)
+    {
+      stack.Push(node->left.get());
+    }
   }
+  S::Record(tally);
+  return true;
+}
 
-  FindByMinMax(node->left, min, max);
-  FindByMinMax(node->right, min, max);
+template <typename T, typename V, typename A, typename S>
+bool IntervalTree<T, V, A, S>::Contains(const Node<T, V, A>* node, T value) const
+{
+  return Overlaps(node, value, value);
 }
 
-template <typename T>
-bool IntervalTree<T>::Contains(std::shared_ptr<Node<T>> node, T value) const
+template <typename T, typename V, typename A, typename S>
+bool IntervalTree<T, V, A, S>::Overlaps(const Node<T, V, A>* node, T low, T high) const
 {
-  if(node == nullptr)
+  // A single root-to-leaf descent: if the left subtree reaches low but holds no
+  // overlap, nothing to the right can overlap either.
+  typename S::Tally tally;
+  while(node && node->max >= low)
   {
-    return false; // No interval found
-  }
+    tally.Visited();
+    if(node->interval.low <= high && node->interval.high >= low)
+    {
+      tally.Reported();
+      S::Record(tally);
+      return true;
+    }
 
-  // Check if the current node's interval contains the value
-  if(node->interval.low <= value && node->interval.high >= value)
-  {
-    return true; // Found a containing interval
+    if(node->left && node->left->max >= low)
+    {
+      node = node->left.get();
+    }
+    else if(node->interval.low <= high)
+    {
+      if(node->left)
+      {
+        tally.Pruned();
+      }
+      node = node->right.get();
+    }
+    else
+    {
+      break;
+    }
   }
-
-  // Traverse the left subtree if it might contain the value
-  if(node->left && node->left->max >= value)
+  if(node && node->max < low)
   {
-    return Contains(node->left, value);
+    tally.Pruned();
   }
-
-  // Always check the right subtree
-  return Contains(node->right, value);
+  S::Record(tally);
+  return false;
 }
 
-template <typename T>
-bool IntervalTree<T>::Overlaps(std::shared_ptr<Node<T>> node, T low, T high) const
+template <typename T, typename V, typename A, typename S>
+int IntervalTree<T, V, A, S>::Height(const Node<T, V, A>* node) const
 {
-  if(node == nullptr)
-  {
-    return false;
-  }
+    return node ? node->height : 0; // Kept up to date by UpdateMax
+}
 
-  if(node->interval.low <= high && node->interval.high >= low)
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::Release(std::shared_ptr<Node<T, V, A> > node)
+{
+  // Children are moved out before a node dies, so no destructor recurses; a balanced tree keeps the stack near its height
+  std::vector<std::shared_ptr<Node<T, V, A> > > stack;
+  if(node)
   {
-    return true;
+    stack.reserve(2 * static_cast<size_t>(node->height) + 1);
+    stack.push_back(std::move(node));
   }
-
-  if(node->left && node->left->max >= low)
+  while(!stack.empty())
   {
-    return Overlaps(node->left, low, high);
+    std::shared_ptr<Node<T, V, A> > top = std::move(stack.back());
+    stack.pop_back();
+    if(top && top.use_count() == 1) // Nodes shared with a snapshot stay intact and are only unreferenced
+    {
+      std::atomic_thread_fence(std::memory_order_acquire); // As in Detach: other versions' reads happen before the children move out
+      stack.push_back(std::move(top->left));
+      stack.push_back(std::move(top->right));
+    }
   }
-
-  return Overlaps(node->right, low, high);
 }
 
-template <typename T>
-int IntervalTree<T>::Height(std::shared_ptr<Node<T>> node) const
+template <typename T, typename V, typename A, typename S>
+int IntervalTree<T, V, A, S>::GetBalance(const Node<T, V, A>* node) const
 {
     if(node == nullptr)
     {
         return 0;
     }
-    return 1 + std::max(Height(node->left), Height(node->right));
+    return Height(node->left.get()) - Height(node->right.get());
 }
 
-template <typename T>
-int IntervalTree<T>::GetBalance(std::shared_ptr<Node<T>> node) const
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::Rebalance(std::shared_ptr<Node<T, V, A> >& slot)
 {
-    if(node == nullptr)
+  Node<T, V, A>* node = slot.get();
+  UpdateMax(node);
+
+  // Check for balance and perform rotations if needed. The child's balance
+  // decides between the single and double rotation, which stays correct when
+  // several intervals share the same low bound.
+  int balance = GetBalance(node);
+  if(balance > 1)
+  {
+    if(GetBalance(node->left.get()) < 0)
     {
-        return 0;
+      RotateLeft(node->left);
+    }
+    RotateRight(slot);
+  }
+  else if(balance < -1)
+  {
+    if(GetBalance(node->right.get()) > 0)
+    {
+      RotateRight(node->right);
     }
-    return Height(node->left) - Height(node->right);
+    RotateLeft(slot);
+  }
 }
 
-template <typename T>
-std::shared_ptr<Node<T>> IntervalTree<T>::RotateRight(std::shared_ptr<Node<T>> node)
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::RotateRight(std::shared_ptr<Node<T, V, A> >& slot)
 {
-    std::shared_ptr<Node<T>> newRoot = node->left;
-    node->left = newRoot->right;
-    newRoot->right = node;
+    // Both nodes change and may still be shared with another version; moves keep the use counts exact
+    S::Rotated();
+    Detach(slot);
+    Detach(slot->left);
+    std::shared_ptr<Node<T, V, A> > node = std::move(slot);
+    std::shared_ptr<Node<T, V, A> > newRoot = std::move(node->left);
+    node->left = std::move(newRoot->right);
 
     // Update the max value of the rotated nodes
-    UpdateMax(node);
-    UpdateMax(newRoot);
+    UpdateMax(node.get());
+    newRoot->right = std::move(node);
+    UpdateMax(newRoot.get());
 
-    return newRoot; // New root of the subtree
+    slot = std::move(newRoot); // New root of the subtree
 }
 
-template <typename T>
-std::shared_ptr<Node<T>> IntervalTree<T>::RotateLeft(std::shared_ptr<Node<T>> node)
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::RotateLeft(std::shared_ptr<Node<T, V, A> >& slot)
 {
-    std::shared_ptr<Node<T>> newRoot = node->right;
-    node->right = newRoot->left;
-    newRoot->left = node;
+    S::Rotated();
+    Detach(slot);
+    Detach(slot->right);
+    std::shared_ptr<Node<T, V, A> > node = std::move(slot);
+    std::shared_ptr<Node<T, V, A> > newRoot = std::move(node->right);
+    node->right = std::move(newRoot->left);
 
     // Update the max value of the rotated nodes
-    UpdateMax(node);
-    UpdateMax(newRoot);
+    UpdateMax(node.get());
+    newRoot->left = std::move(node);
+    UpdateMax(newRoot.get());
 
-    return newRoot; // New root of the subtree
+    slot = std::move(newRoot); // New root of the subtree
 }
 
-template <typename T>
-void IntervalTree<T>::ToString(std::shared_ptr<Node<T>> node, std::ostringstream& oss) const
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::CollectInOrder(const Node<T, V, A>* node,
+  std::vector<std::pair<Interval<T>, V> >& result) const
 {
-  if(node)
+  IntervalTreeDetail::NodeStack<const Node<T, V, A>*> stack(Height(node));
+  while(node || !stack.IsEmpty())
   {
-    ToString(node->left, oss);
-    oss << "[" << node->interval.low << ", " << node->interval.high << "] ";
-    ToString(node->right, oss);
+    while(node)
+    {
+      stack.Push(node);
+      node = node->left.get();
+    }
+    node = stack.Pop();
+    result.emplace_back(node->interval, node->data);
+    node = node->right.get();
   }
 }
-#endif
 
+template <typename T, typename V, typename A, typename S>
+std::shared_ptr<Node<T, V, A> > IntervalTree<T, V, A, S>::Build(std::vector<std::pair<Interval<T>, V> >& entries,
+  size_t begin, size_t end)
+{
+  if(begin >= end)
+  {
+    return nullptr;
+  }
+
+  // The median becomes the subtree root; max and height are filled in once both children exist
+  size_t mid = begin + (end - begin) / 2;
+  std::shared_ptr<Node<T, V, A> > node = std::make_shared<Node<T, V, A> >(entries[mid].first, std::move(entries[mid].second));
+  node->left = Build(entries, begin, mid);
+  node->right = Build(entries, mid + 1, end);
+  UpdateMax(node.get());
+  return node;
+}
+
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::SortByLow(std::vector<std::pair<Interval<T>, V> >& entries, bool parallel)
+{
+  typedef typename std::vector<std::pair<Interval<T>, V> >::iterator Iterator;
+  auto byLow = [](const std::pair<Interval<T>, V>& a, const std::pair<Interval<T>, V>& b)
+  {
+    return a.first.low < b.first.low;
+  };
+
+  size_t chunks = parallel ? std::thread::hardware_concurrency() : 1;
+  const size_t minChunk = 1 << 14; // Below this, a thread costs more than it saves
+  chunks = std::min(chunks, entries.size() / minChunk);
+  if(chunks < 2)
+  {
+    std::stable_sort(entries.begin(), entries.end(), byLow);
+    return;
+  }
+
+  // Sort equal-sized chunks concurrently, then merge neighbouring runs pairwise
+  std::vector<size_t> bounds;
+  for(size_t c = 0; c <= chunks; ++c)
+  {
+    bounds.push_back(entries.size() * c / chunks);
+  }
+
+  std::vector<std::thread> workers;
+  for(size_t c = 0; c < chunks; ++c)
+  {
+    Iterator first = entries.begin() + bounds[c];
+    Iterator last = entries.begin() + bounds[c + 1];
+    workers.emplace_back([first, last, byLow]() { std::stable_sort(first, last, byLow); });
+  }
+  for(std::thread& worker : workers)
+  {
+    worker.join();
+  }
+
+  while(bounds.size() > 2)
+  {
+    std::vector<size_t> next;
+    workers.clear();
+    for(size_t c = 0; c + 2 < bounds.size(); c += 2)
+    {
+      Iterator first = entries.begin() + bounds[c];
+      Iterator middle = entries.begin() + bounds[c + 1];
+      Iterator last = entries.begin() + bounds[c + 2];
+      workers.emplace_back([first, middle, last, byLow]() { std::inplace_merge(first, middle, last, byLow); });
+      next.push_back(bounds[c]);
+    }
+    if(bounds.size() % 2 == 0)
+    {
+      next.push_back(bounds[bounds.size() - 2]); // An odd run out is carried over unmerged
+    }
+    next.push_back(bounds.back());
+    for(std::thread& worker : workers)
+    {
+      worker.join();
+    }
+    bounds.swap(next);
+  }
+}
+
+template <typename T, typename V, typename A, typename S>
+void IntervalTree<T, V, A, S>::FindBatch(std::vector<IntervalTreeDetail::BatchQuery<T> >& queries, bool points,
+  IntervalBatchResult<T, V>& result) const
+{
+  typedef IntervalTreeDetail::BatchQuery<T> Query;
+  const size_t count = queries.size();
+  std::sort(queries.begin(), queries.end(), [](const Query& a, const Query& b) { return a.low < b.low; });
+
+  // First index in [begin, end) whose low is > value (or >= value when inclusive is false)
+  auto boundLow = [&queries](size_t begin, size_t end, T value, bool inclusive) -> size_t
+  {
+    return inclusive
+      ? std::upper_bound(queries.begin() + begin, queries.begin() + end, value,
+          [](T v, const Query& q) { return v < q.low; }) - queries.begin()
+      : std::lower_bound(queries.begin() + begin, queries.begin() + end, value,
+          [](const Query& q, T v) { return q.low < v; }) - queries.begin();
+  };
+
+  // Each frame is a subtree plus the contiguous, still sorted run of queries that
+  // may reach it. Runs that need filtering are appended to the queries vector, and
+  // mark records its size when the frame was pushed, so everything past it belongs
+  // to subtrees that are already finished once the frame is popped.
+  struct Frame
+  {
+    const Node<T, V, A>* node;
+    size_t begin;
+    size_t end;
+    size_t mark;
+  };
+  std::vector<Frame> stack;
+  std::vector<std::pair<size_t, const Node<T, V, A>*> > found;
+  if(Root && count > 0)
+  {
+    stack.push_back(Frame{Root.get(), 0, count, count});
+  }
+
+  while(!stack.empty())
+  {
+    Frame frame = stack.back();
+    stack.pop_back();
+    queries.resize(frame.mark);
+
+    const Node<T, V, A>* node = frame.node;
+    size_t end = boundLow(frame.begin, frame.end, node->max, true); // Lows past the subtree max cannot hit it
+    if(end == frame.begin)
+    {
+      continue;
+    }
+
+    // Queries with low <= node->interval.high form a prefix; of those, the ones
+    // whose high reaches node->interval.low hit the node
+    size_t reachEnd = boundLow(frame.begin, end, node->interval.high, true);
+    size_t reachBegin = points ? boundLow(frame.begin, reachEnd, node->interval.low, false) : frame.begin;
+    for(size_t q = reachBegin; q < reachEnd; ++q)
+    {
+      if(queries[q].high >= node->interval.low)
+      {
+        found.push_back(std::make_pair(queries[q].index, node));
+      }
+    }
+
+    // Lows in the right subtree are at least node->interval.low, so only queries
+    // whose high reaches it go on. For points that is a suffix of the run.
+    if(node->right)
+    {
+      if(points)
+      {
+        size_t begin = boundLow(frame.begin, end, node->interval.low, false);
+        if(begin < end)
+        {
+          stack.push_back(Frame{node->right.get(), begin, end, queries.size()});
+        }
+      }
+      else
+      {
+        size_t q = frame.begin;
+        while(q < end && queries[q].high >= node->interval.low)
+        {
+          ++q;
+        }
+        if(q == end)
+        {
+          stack.push_back(Frame{node->right.get(), frame.begin, end, queries.size()});
+        }
+        else
+        {
+          size_t begin = queries.size();
+          for(size_t r = frame.begin; r < end; ++r)
+          {
+            if(queries[r].high >= node->interval.low)
+            {
+              Query copy = queries[r]; // The push may reallocate the vector
+              queries.push_back(copy);
+            }
+          }
+          if(queries.size() > begin)
+          {
+            stack.push_back(Frame{node->right.get(), begin, queries.size(), queries.size()});
+          }
+        }
+      }
+    }
+
+    if(node->left)
+    {
+      stack.push_back(Frame{node->left.get(), frame.begin, end, queries.size()});
+    }
+  }
+
+  IntervalTreeDetail::GatherBatch(found, count, result,
+    [](const Node<T, V, A>* hit) { return std::make_pair(hit->interval, hit->data); });
+}
+#endif
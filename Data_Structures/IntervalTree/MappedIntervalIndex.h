@@ -0,0 +1,316 @@
+//---------------------------------------------------------------------------
+
+#ifndef MappedIntervalIndexH
+#define MappedIntervalIndexH
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "IntervalTree.h"
+#include "IntervalIndexFile.h"
+#include "StaticIntervalIndex.h"
+
+/**
+ * @tparam T The type of the interval bounds.
+ * @tparam V The type of the payload stored with each interval; must be trivially copyable.
+ * @class MappedIntervalIndex
+ * @brief A read-only interval index queried in place from a file written by StaticIntervalIndex::Save.
+ *
+ * Opening the index maps the file and checks its header. Nothing is parsed
+ * or copied, so opening costs the same for any file size, and each query
+ * only faults in the pages it touches. Processes that map the same file
+ * share one copy of it in the page cache.
+ *
+ * The file must not be modified while it is mapped. Concurrent queries are safe.
+ */
+template <typename T = int, typename V = int>
+class MappedIntervalIndex
+{
+  static_assert(std::is_trivially_copyable<V>::value, "Only trivially copyable payloads can be mapped.");
+
+  public:
+    /**
+     * @brief Maps an index file.
+     * @param path The file written by StaticIntervalIndex::Save.
+     * @throws std::runtime_error if the file cannot be mapped, is corrupt, or holds other key or payload types.
+     */
+    explicit MappedIntervalIndex(const std::string& path);
+
+    ~MappedIntervalIndex(); ///< Unmaps the file.
+
+    MappedIntervalIndex(MappedIntervalIndex&& other); ///< Takes over the mapping of other.
+    MappedIntervalIndex& operator=(MappedIntervalIndex&& other); ///< Takes over the mapping of other.
+
+    /**
+     * @brief Finds all intervals that contain a specific value.
+     * @param value The value to check for containment.
+     * @return A vector of intervals that contain the specified value.
+     */
+    std::vector<std::pair<Interval<T>, V> > Containing(T value) const;
+
+    /**
+     * @brief Finds the intervals containing each of a batch of points, interleaving one walk per point to hide memory latency.
+     *
+     * Up to group walks are in flight and take turns advancing one slot of the
+     * mapping, prefetching the keys of the slots they visit next; see
+     * IntervalTree::ContainingInterleaved.
+     *
+     * @param points The query points, in any order.
+     * @param count The number of query points.
+     * @param group The number of walks in flight.
+     * @return The hits of each point, in the order the points were given.
+     */
+    IntervalBatchResult<T, V> ContainingInterleaved(const T* points, size_t count, size_t group = 16) const;
+
+    /**
+     * @brief Finds all intervals that overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return A vector of intervals that overlap with the specified range.
+     */
+    std::vector<std::pair<Interval<T>, V> > Overlapping(T low, T high) const;
+
+    /**
+     * @brief Calls a visitor for every interval that overlaps with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @param visit The callable invoked as visit(const Interval<T>&, const V&); returning false stops the query.
+     */
+    template <typename Visitor>
+    void ForEachOverlapping(T low, T high, Visitor visit) const;
+
+    /**
+     * @brief Checks if a specific value is contained within any interval.
+     * @param value The value to check.
+     * @return True if the value is contained in any interval, false otherwise.
+     */
+    bool Contains(T value) const;
+
+    /**
+     * @brief Checks if any intervals overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return True if there are overlapping intervals, false otherwise.
+     */
+    bool Overlaps(T low, T high) const;
+
+    /**
+     * @brief Checks whether the index is empty.
+     * @return True if the index holds no intervals, false otherwise.
+     */
+    bool IsEmpty(void) const;
+
+    /**
+     * @brief Gets the number of intervals in the index.
+     * @return The number of intervals in the index.
+     */
+    size_t Size() const;
+
+  private:
+    const char* base; ///< The start of the mapping.
+    uint64_t length; ///< The length of the mapping.
+    IntervalTreeDetail::EytzingerView<T, V> view; ///< Points into the mapping.
+#if defined(_WIN32)
+    HANDLE file; ///< The open file.
+    HANDLE mapping; ///< The file mapping object.
+#endif
+
+    MappedIntervalIndex(const MappedIntervalIndex&); ///< Not copyable: the mapping has one owner.
+    MappedIntervalIndex& operator=(const MappedIntervalIndex&); ///< Not copyable: the mapping has one owner.
+
+    void Unmap(); ///< Releases the mapping, if any.
+};
+
+
+template <typename T, typename V>
+MappedIntervalIndex<T, V>::MappedIntervalIndex(const std::string& path) : base(nullptr), length(0)
+{
+#if defined(_WIN32)
+  file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  mapping = nullptr;
+  LARGE_INTEGER size;
+  if(file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size))
+  {
+    Unmap();
+    throw std::runtime_error("Cannot open interval index file: " + path);
+  }
+  length = static_cast<uint64_t>(size.QuadPart);
+  mapping = length ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+  base = mapping ? static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  struct stat info;
+  if(fd < 0 || fstat(fd, &info) != 0)
+  {
+    if(fd >= 0)
+    {
+      close(fd);
+    }
+    throw std::runtime_error("Cannot open interval index file: " + path);
+  }
+  length = static_cast<uint64_t>(info.st_size);
+  void* address = length ? mmap(nullptr, static_cast<size_t>(length), PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+  close(fd); // The mapping keeps the file alive
+  base = address == MAP_FAILED ? nullptr : static_cast<const char*>(address);
+#endif
+  if(base == nullptr)
+  {
+    Unmap();
+    throw std::runtime_error("Cannot map interval index file: " + path);
+  }
+
+  const IntervalIndexFile::Header& header = *reinterpret_cast<const IntervalIndexFile::Header*>(base);
+  try
+  {
+    IntervalIndexFile::Validate<T, V>(header, length, path);
+  }
+  catch(...)
+  {
+    Unmap();
+    throw;
+  }
+  view.lows = reinterpret_cast<const T*>(base + header.lowsOffset);
+  view.highs = reinterpret_cast<const T*>(base + header.highsOffset);
+  view.maxes = reinterpret_cast<const T*>(base + header.maxesOffset);
+  view.data = reinterpret_cast<const V*>(base + header.dataOffset);
+  view.count = static_cast<size_t>(header.count);
+}
+
+template <typename T, typename V>
+MappedIntervalIndex<T, V>::~MappedIntervalIndex()
+{
+  Unmap();
+}
+
+template <typename T, typename V>
+MappedIntervalIndex<T, V>::MappedIntervalIndex(MappedIntervalIndex&& other)
+  : base(other.base), length(other.length), view(other.view)
+{
+#if defined(_WIN32)
+  file = other.file;
+  mapping = other.mapping;
+  other.file = INVALID_HANDLE_VALUE;
+  other.mapping = nullptr;
+#endif
+  other.base = nullptr;
+  other.length = 0;
+  other.view.count = 0;
+}
+
+template <typename T, typename V>
+MappedIntervalIndex<T, V>& MappedIntervalIndex<T, V>::operator=(MappedIntervalIndex&& other)
+{
+  if(this != &other)
+  {
+    Unmap();
+    base = other.base;
+    length = other.length;
+    view = other.view;
+#if defined(_WIN32)
+    file = other.file;
+    mapping = other.mapping;
+    other.file = INVALID_HANDLE_VALUE;
+    other.mapping = nullptr;
+#endif
+    other.base = nullptr;
+    other.length = 0;
+    other.view.count = 0;
+  }
+  return *this;
+}
+
+template <typename T, typename V>
+std::vector<std::pair<Interval<T>, V> > MappedIntervalIndex<T, V>::Containing(T value) const
+{
+  return Overlapping(value, value);
+}
+
+template <typename T, typename V>
+IntervalBatchResult<T, V> MappedIntervalIndex<T, V>::ContainingInterleaved(const T* points, size_t count, size_t group) const
+{
+  return view.ContainingInterleaved(points, count, group);
+}
+
+template <typename T, typename V>
+std::vector<std::pair<Interval<T>, V> > MappedIntervalIndex<T, V>::Overlapping(T low, T high) const
+{
+  std::vector<std::pair<Interval<T>, V> > result;
+  auto collect = [&result](const Interval<T>& i, const V& payload)
+  {
+    result.emplace_back(i, payload);
+  };
+  view.FindOverlapping(low, high, collect);
+  return result;
+}
+
+template <typename T, typename V>
+template <typename Visitor>
+void MappedIntervalIndex<T, V>::ForEachOverlapping(T low, T high, Visitor visit) const
+{
+  view.FindOverlapping(low, high, visit);
+}
+
+template <typename T, typename V>
+bool MappedIntervalIndex<T, V>::Contains(T value) const
+{
+  return Overlaps(value, value);
+}
+
+template <typename T, typename V>
+bool MappedIntervalIndex<T, V>::Overlaps(T low, T high) const
+{
+  return view.Overlaps(low, high);
+}
+
+template <typename T, typename V>
+bool MappedIntervalIndex<T, V>::IsEmpty() const
+{
+  return view.count == 0;
+}
+
+template <typename T, typename V>
+size_t MappedIntervalIndex<T, V>::Size() const
+{
+  return view.count;
+}
+
+template <typename T, typename V>
+void MappedIntervalIndex<T, V>::Unmap()
+{
+#if defined(_WIN32)
+  if(base)
+  {
+    UnmapViewOfFile(base);
+  }
+  if(mapping)
+  {
+    CloseHandle(mapping);
+  }
+  if(file != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(file);
+  }
+  mapping = nullptr;
+  file = INVALID_HANDLE_VALUE;
+#else
+  if(base)
+  {
+    munmap(const_cast<char*>(base), static_cast<size_t>(length));
+  }
+#endif
+  base = nullptr;
+  length = 0;
+}
+#endif
@@ -0,0 +1,178 @@
+//---------------------------------------------------------------------------
+
+#ifndef ParallelQueryH
+#define ParallelQueryH
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "IntervalTree.h"
+
+/**
+ * @tparam T The type of the interval bounds.
+ * @tparam V The type of the payload stored with each interval.
+ * @tparam A The augmentation policy of the tree.
+ * @tparam S The statistics policy of the tree.
+ * @class ParallelQuery
+ * @brief Runs batch queries against one shared, read-only IntervalTree on several threads.
+ *
+ * A batch is sorted once and cut into contiguous key ranges, one per worker,
+ * so each thread sweeps its own region of the tree and keeps that part of it
+ * in its cache. Every worker writes to its own result buffer; the buffers are
+ * then merged back into the caller's query order, so the result does not
+ * depend on thread scheduling. Batches too small to be worth splitting run
+ * on the calling thread.
+ *
+ * Thread safety: the tree must not be modified while a query runs. A
+ * ParallelQuery is itself stateless after construction, so one instance may
+ * serve several calling threads at once. Workers are started per batch with
+ * std::thread and joined before the call returns.
+ */
+template <typename T = int, typename V = std::shared_ptr<T>, typename A = NoAugmentation, typename S = NoStats>
+class ParallelQuery
+{
+  public:
+    /**
+     * @brief Binds the facility to a tree.
+     * @param tree The tree to query; it must outlive this object.
+     * @param threads The number of worker threads, or 0 for std::thread::hardware_concurrency().
+     */
+    explicit ParallelQuery(const IntervalTree<T, V, A, S>& tree, unsigned threads = 0);
+
+    /**
+     * @brief Finds the intervals containing each of a batch of points.
+     * @param points The query points, in any order.
+     * @param count The number of query points.
+     * @return The hits of each point in CSR form, in the order the points were given.
+     */
+    IntervalBatchResult<T, V> Containing(const T* points, size_t count) const;
+
+    /**
+     * @brief Finds the intervals overlapping each of a batch of ranges.
+     * @param ranges The query ranges, in any order.
+     * @param count The number of query ranges.
+     * @return The hits of each range in CSR form, in the order the ranges were given.
+     */
+    IntervalBatchResult<T, V> Overlapping(const Interval<T>* ranges, size_t count) const;
+
+    /**
+     * @brief Gets the number of worker threads a large batch is split across.
+     * @return The number of worker threads.
+     */
+    unsigned Threads() const;
+
+  private:
+    const IntervalTree<T, V, A, S>& tree; ///< The shared tree all workers read.
+    unsigned threads; ///< The number of worker threads.
+
+    static const size_t MinChunk = 1 << 12; ///< The smallest share of a batch worth a thread of its own.
+
+    /**
+     * @brief Sorts the batch, answers one key range per worker, and merges the results in caller order.
+     */
+    template <typename Query, typename Low, typename Answer>
+    IntervalBatchResult<T, V> Run(const Query* queries, size_t count, Low low, Answer answer) const;
+};
+
+
+template <typename T, typename V, typename A, typename S>
+ParallelQuery<T, V, A, S>::ParallelQuery(const IntervalTree<T, V, A, S>& tree, unsigned threads)
+  : tree(tree), threads(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+template <typename T, typename V, typename A, typename S>
+IntervalBatchResult<T, V> ParallelQuery<T, V, A, S>::Containing(const T* points, size_t count) const
+{
+  return Run(points, count,
+    [](const T& point) { return point; },
+    [this](const T* first, size_t n) { return tree.Containing(first, n); });
+}
+
+template <typename T, typename V, typename A, typename S>
+IntervalBatchResult<T, V> ParallelQuery<T, V, A, S>::Overlapping(const Interval<T>* ranges, size_t count) const
+{
+  return Run(ranges, count,
+    [](const Interval<T>& range) { return range.low; },
+    [this](const Interval<T>* first, size_t n) { return tree.Overlapping(first, n); });
+}
+
+template <typename T, typename V, typename A, typename S>
+unsigned ParallelQuery<T, V, A, S>::Threads() const
+{
+  return threads;
+}
+
+template <typename T, typename V, typename A, typename S>
+template <typename Query, typename Low, typename Answer>
+IntervalBatchResult<T, V> ParallelQuery<T, V, A, S>::Run(const Query* queries, size_t count, Low low, Answer answer) const
+{
+  size_t workers = std::min<size_t>(threads, count / MinChunk);
+  if(workers < 2)
+  {
+    return answer(queries, count);
+  }
+
+  // Sort once so each worker gets a contiguous key range of the tree
+  std::vector<size_t> order(count);
+  for(size_t q = 0; q < count; ++q)
+  {
+    order[q] = q;
+  }
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return low(queries[a]) < low(queries[b]); });
+  std::vector<Query> sorted(count);
+  for(size_t q = 0; q < count; ++q)
+  {
+    sorted[q] = queries[order[q]];
+  }
+
+  std::vector<size_t> bounds(workers + 1);
+  for(size_t w = 0; w <= workers; ++w)
+  {
+    bounds[w] = count * w / workers;
+  }
+
+  std::vector<IntervalBatchResult<T, V> > partial(workers);
+  std::vector<std::thread> pool;
+  for(size_t w = 0; w < workers; ++w)
+  {
+    pool.emplace_back([&, w]()
+    {
+      partial[w] = answer(sorted.data() + bounds[w], bounds[w + 1] - bounds[w]);
+    });
+  }
+  for(std::thread& worker : pool)
+  {
+    worker.join();
+  }
+
+  // Scatter the per-worker hit counts back to the caller's query positions, then copy the hits
+  IntervalBatchResult<T, V> result;
+  result.offsets.assign(count + 1, 0);
+  for(size_t w = 0; w < workers; ++w)
+  {
+    for(size_t local = 0; local < partial[w].Size(); ++local)
+    {
+      result.offsets[order[bounds[w] + local] + 1] = partial[w].Count(local);
+    }
+  }
+  for(size_t q = 0; q < count; ++q)
+  {
+    result.offsets[q + 1] += result.offsets[q];
+  }
+
+  result.hits.resize(result.offsets[count]);
+  for(size_t w = 0; w < workers; ++w)
+  {
+    const IntervalBatchResult<T, V>& part = partial[w];
+    for(size_t local = 0; local < part.Size(); ++local)
+    {
+      std::copy(part.hits.begin() + part.offsets[local], part.hits.begin() + part.offsets[local + 1],
+        result.hits.begin() + result.offsets[order[bounds[w] + local]]);
+    }
+  }
+  return result;
+}
+#endif
@@ -0,0 +1,807 @@
+//---------------------------------------------------------------------------
+
+#ifndef PooledIntervalTreeH
+#define PooledIntervalTreeH
+
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "IntervalTree.h"
+#include "IntervalSimd.h"
+
+namespace IntervalTreeDetail
+{
+  /**
+   * @brief Gets the smallest power of two that holds size bytes, or size itself if that is more than a cache line.
+   */
+  constexpr size_t CacheFit(size_t size, size_t fit = 1)
+  {
+    return fit >= size ? fit : fit >= IntervalSimd::CacheLine ? size : CacheFit(size, 2 * fit);
+  }
+
+  template <size_t Bytes>
+  struct Padding
+  {
+    char unused[Bytes]; ///< Never read or written.
+  };
+
+  template <>
+  struct Padding<0> {};
+
+  /**
+   * @brief The search fields of a PooledNode, the only part of it a query reads.
+   */
+  template <typename T>
+  struct PooledFields
+  {
+    Interval<T> interval; ///< The interval associated with this node.
+    T max; ///< The maximum value in the subtree (to help with overlap checks).
+    uint32_t left; ///< Pool index of the left child node, or PooledNode<T>::Null.
+    uint32_t right; ///< Pool index of the right child node, or PooledNode<T>::Null.
+    int height; ///< The height of the subtree rooted at this node (a leaf has height 1).
+
+    explicit PooledFields(Interval<T> i) : interval(i), max(i.high), left(0xFFFFFFFFu), right(0xFFFFFFFFu), height(1) {}
+  };
+}
+
+/**
+ * @tparam T The type of data stored in the node.
+ * @struct PooledNode
+ * @brief Represents a node of a PooledIntervalTree, linked to its children by 32-bit pool indices.
+ *
+ * The node holds only what a query reads on its way down; the payload lives
+ * in a separate array of the NodePool. The search fields are padded up to a
+ * power of two no larger than a cache line, so in a cache-line-aligned slab
+ * no node straddles two lines. With int keys a node takes 32 bytes and two
+ * share a line.
+ */
+template <typename T>
+struct PooledNode : IntervalTreeDetail::PooledFields<T>,
+  IntervalTreeDetail::Padding<IntervalTreeDetail::CacheFit(sizeof(IntervalTreeDetail::PooledFields<T>)) - sizeof(IntervalTreeDetail::PooledFields<T>)>
+{
+  static const uint32_t Null = 0xFFFFFFFFu; ///< Index value used for a missing child.
+
+  typedef std::shared_ptr<T> Payload; ///< The type of the data kept in the payload array of the pool.
+
+  /**
+   * @brief Constructs a leaf PooledNode with a given interval.
+   * @param i The interval for this node.
+   */
+  explicit PooledNode(Interval<T> i) : IntervalTreeDetail::PooledFields<T>(i) {}
+};
+
+template <typename T>
+const uint32_t PooledNode<T>::Null;
+
+/**
+ * @tparam NodeType The node type kept in the pool.
+ * @tparam Allocator The allocator used for the pool storage (rebound to NodeType).
+ * @class NodePool
+ * @brief Contiguous node storage addressed by 32-bit indices, with a free list for reuse.
+ *
+ * All nodes live in a single growable slab, so allocating a node is an
+ * amortised O(1) append (or a free-list pop) instead of a heap allocation,
+ * and clearing the pool releases every node at once. NodeType must expose a
+ * static Null index, a uint32_t left link (used to chain free slots) and a
+ * Payload type.
+ *
+ * Payloads are kept in a second array at the same indices. A search reads
+ * only the slab of nodes and touches a payload only for the hits it reports,
+ * so the cache lines it pulls in hold nothing but search fields.
+ */
+template <typename NodeType, typename Allocator = std::allocator<NodeType> >
+class NodePool
+{
+  public:
+    typedef typename NodeType::Payload Payload;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<NodeType> NodeAllocator;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Payload> PayloadAllocator;
+
+    explicit NodePool(const Allocator& alloc = Allocator())
+      : nodes(NodeAllocator(alloc)), payloads(PayloadAllocator(alloc)), freeList(NodeType::Null), live(0) {} ///< Constructs an empty pool.
+
+    /**
+     * @brief Stores a new node in the pool, with a default-constructed payload.
+     * @param args The arguments forwarded to the NodeType constructor.
+     * @return The index of the new node.
+     */
+    template <typename... Args>
+    uint32_t Allocate(Args&&... args);
+
+    /**
+     * @brief Returns a node to the free list so its slot can be reused, dropping its payload.
+     * @param index The index of the node to release.
+     */
+    void Release(uint32_t index);
+
+    /**
+     * @brief Releases every node in the pool at once.
+     */
+    void Clear(void);
+
+    /**
+     * @brief Reserves storage for at least the given number of nodes.
+     * @param count The number of nodes to reserve.
+     */
+    void Reserve(size_t count);
+
+    /**
+     * @brief Gets the number of bytes held by the pool storage.
+     * @return The capacity of the node slab and the payload array in bytes.
+     */
+    size_t MemoryUsage() const;
+
+    /**
+     * @brief Starts loading a node into the cache, ahead of the visit that reads it.
+     * @param index The index of the node, or NodeType::Null.
+     */
+    void Prefetch(uint32_t index) const
+    {
+      if(index != NodeType::Null)
+      {
+        IntervalTreeDetail::Prefetch(&nodes[index]);
+      }
+    }
+
+    NodeType& operator[](uint32_t index) { return nodes[index]; } ///< Accesses the node at the given index.
+    const NodeType& operator[](uint32_t index) const { return nodes[index]; } ///< Accesses the node at the given index.
+
+    Payload& Data(uint32_t index) { return payloads[index]; } ///< Accesses the payload of the node at the given index.
+    const Payload& Data(uint32_t index) const { return payloads[index]; } ///< Accesses the payload of the node at the given index.
+
+  private:
+    std::vector<NodeType, NodeAllocator> nodes; ///< The slab holding every node, live or free.
+    std::vector<Payload, PayloadAllocator> payloads; ///< The payload of each slot, apart from the search fields.
+    uint32_t freeList; ///< Index of the first free slot, chained through the left links.
+    size_t live; ///< The number of nodes currently in use.
+};
+
+/**
+ * @tparam T The type of data stored in the interval tree.
+ * @tparam Allocator The allocator used for the node pool.
+ * @class PooledIntervalTree
+ * @brief An interval tree with the IntervalTree API whose nodes live in a NodePool.
+ *
+ * Nodes are linked by 32-bit indices instead of std::shared_ptr, which drops the
+ * per-node heap allocation and control block, and keeps the recursive helpers free
+ * of reference count traffic. Interval payloads keep the std::shared_ptr<T> type
+ * used by IntervalTree so the two are interchangeable.
+ *
+ * The nodes hold only the search fields, and the default allocator places
+ * their slab on a cache-line boundary; the payloads sit in a parallel array.
+ * A query prefetches both children of a node before it compares against the
+ * node, so on trees larger than the cache the next level is already on its
+ * way.
+ */
+template <typename T = int, typename Allocator = IntervalSimd::AlignedAllocator<T> >
+class PooledIntervalTree
+{
+  public:
+    typedef PooledNode<T> NodeType;
+
+    explicit PooledIntervalTree(const Allocator& alloc = Allocator())
+      : pool(alloc), Root(NodeType::Null), size(0) {} ///< Constructs an empty PooledIntervalTree.
+
+    void Insert(T low, T high, std::shared_ptr<T> data = nullptr); ///< Inserts a new interval into the tree.
+    void Insert(Interval<T> i, std::shared_ptr<T> data = nullptr); ///< Inserts a new interval into the tree.
+    bool Remove(Interval<T> i); ///< Removes an interval (matching both bounds); returns false if none matched.
+    bool Update(Interval<T> oldInterval, Interval<T> newInterval, std::shared_ptr<T> newData = nullptr); ///< Replaces an interval; returns whether oldInterval was found.
+
+    /**
+     * @brief Finds all intervals that contain a specific value.
+     * @param value The value to check for containment.
+     * @return A vector of intervals that contain the specified value.
+     */
+    std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > Containing(T value) const;
+
+    /**
+     * @brief Finds all intervals that overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return A vector of intervals that overlap with the specified range.
+     */
+    std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > Overlapping(T low, T high) const;
+
+    /**
+     * @brief Finds the maximum high value of all intervals that overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return The maximum high value of the overlapping intervals, or the lowest value of T if there are none.
+     */
+    T MaxHighOverlapping(T low, T high) const;
+
+    /**
+     * @brief Checks if a specific value is contained within any interval.
+     * @param value The value to check.
+     * @return True if the value is contained in any interval, false otherwise.
+     */
+    bool Contains(T value) const;
+
+    /**
+     * @brief Checks if any intervals overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return True if there are overlapping intervals, false otherwise.
+     */
+    bool Overlaps(T low, T high) const;
+
+    /**
+     * @brief Clears the entire interval tree, releasing all nodes in one step.
+     */
+    void Clear(void);
+
+    /**
+     * @brief Empties the tree in O(1) and frees the pool storage on a background thread.
+     *
+     * The slab is trivially destructible, so the thread's work is the payload
+     * array and the two deallocations. As with any std::async future, the one
+     * returned waits for that work when it is destroyed.
+     *
+     * @return A future that becomes ready once the storage is freed.
+     */
+    std::future<void> ClearAsync();
+
+    /**
+     * @brief Reserves pool storage for the given number of intervals.
+     * @param count The number of intervals to reserve room for.
+     */
+    void Reserve(size_t count);
+
+    /**
+     * @brief Checks whether the tree is empty.
+     * @return True if the tree is empty, false otherwise.
+     */
+    bool IsEmpty(void) const;
+
+    /**
+     * @brief Converts the interval tree to an in-order string representation.
+     * @return A string representation of the intervals in the tree.
+     */
+    std::string ToString() const;
+
+    /**
+     * @brief Gets the number of intervals in the tree.
+     * @return The number of intervals in the tree.
+     */
+    size_t Size() const;
+
+    /**
+     * @brief Gets the number of bytes held by the node pool.
+     * @return The footprint of the node slab and the payload array in bytes (what the payloads point to not included).
+     */
+    size_t MemoryUsage() const;
+
+  private:
+    NodePool<NodeType, Allocator> pool; ///< The storage for all nodes of the tree.
+    uint32_t Root; ///< The pool index of the root, or NodeType::Null.
+    size_t size; ///< The number of intervals in the tree.
+
+    /**
+     * @brief Helper function to insert an interval.
+     */
+    uint32_t Insert(uint32_t node, Interval<T> i, const std::shared_ptr<T>& data);
+
+    /**
+     * @brief Helper function to remove an interval.
+     */
+    uint32_t Remove(uint32_t node, const Interval<T>& i, bool& removed);
+
+    /**
+     * @brief Removes the leftmost node of the subtree.
+     */
+    uint32_t RemoveMin(uint32_t node);
+
+    /**
+     * @brief Updates the cached maximum value and height of the node from its children.
+     */
+    void UpdateMax(uint32_t node);
+
+    /**
+     * @brief Restores the AVL balance of the node after one of its subtrees changed.
+     */
+    uint32_t Rebalance(uint32_t node);
+
+    /**
+     * @brief Finds intervals containing a specific value.
+     */
+    void FindContaining(uint32_t node, T value,
+      std::vector<std::pair<Interval<T>, std::shared_ptr<T> > >& result) const;
+
+    /**
+     * @brief Finds overlapping intervals with a given range.
+     */
+    void FindOverlapping(uint32_t node, T low, T high,
+      std::vector<std::pair<Interval<T>, std::shared_ptr<T> > >& result) const;
+
+    /**
+     * @brief Finds the max high value of the overlapping intervals with a given range.
+     */
+    void MaxHighOverlapping(uint32_t node, T low, T high, T& maxValue) const;
+
+    /**
+     * @brief Checks for overlaps in the tree.
+     */
+    bool Overlaps(uint32_t node, T low, T high) const;
+
+    /**
+     * @brief Returns the cached height of the subtree rooted at the given node.
+     */
+    int Height(uint32_t node) const;
+
+    /**
+     * @brief Calculates the balance factor of the given node.
+     */
+    int GetBalance(uint32_t node) const;
+
+    /**
+     * @brief Performs a right rotation on the given node.
+     */
+    uint32_t RotateRight(uint32_t node);
+
+    /**
+     * @brief Performs a left rotation on the given node.
+     */
+    uint32_t RotateLeft(uint32_t node);
+
+    void ToString(uint32_t node, std::ostringstream& oss) const;
+};
+
+
+template <typename NodeType, typename Allocator>
+template <typename... Args>
+uint32_t NodePool<NodeType, Allocator>::Allocate(Args&&... args)
+{
+  uint32_t index;
+  if(freeList != NodeType::Null)
+  {
+    index = freeList;
+    freeList = nodes[index].left;
+    nodes[index] = NodeType(std::forward<Args>(args)...); // Release already reset the payload
+  }
+  else
+  {
+    if(nodes.size() >= NodeType::Null)
+    {
+      throw std::length_error("NodePool: too many nodes for 32-bit indices.");
+    }
+    index = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back(std::forward<Args>(args)...);
+    payloads.emplace_back();
+  }
+  live++;
+  return index;
+}
+
+template <typename NodeType, typename Allocator>
+void NodePool<NodeType, Allocator>::Release(uint32_t index)
+{
+  payloads[index] = Payload(); // Drop the payload now rather than when the slot is reused
+  nodes[index].left = freeList;
+  freeList = index;
+  live--;
+}
+
+template <typename NodeType, typename Allocator>
+void NodePool<NodeType, Allocator>::Clear()
+{
+  nodes.clear();
+  payloads.clear();
+  freeList = NodeType::Null;
+  live = 0;
+}
+
+template <typename NodeType, typename Allocator>
+void NodePool<NodeType, Allocator>::Reserve(size_t count)
+{
+  nodes.reserve(count);
+  payloads.reserve(count);
+}
+
+template <typename NodeType, typename Allocator>
+size_t NodePool<NodeType, Allocator>::MemoryUsage() const
+{
+  return nodes.capacity() * sizeof(NodeType) + payloads.capacity() * sizeof(Payload);
+}
+
+template <typename T, typename Allocator>
+void PooledIntervalTree<T, Allocator>::Insert(T low, T high, std::shared_ptr<T> data)
+{
+  Interval<T> i(low, high);
+  Insert(i, data);
+}
+
+template <typename T, typename Allocator>
+void PooledIntervalTree<T, Allocator>::Insert(Interval<T> i, std::shared_ptr<T> data)
+{
+  if(i.low > i.high)
+  {
+    throw std::invalid_argument("Invalid interval: low must be less than or equal to high.");
+  }
+  Root = Insert(Root, i, data);
+  size++; // Increment size on successful insertion
+}
+
+template <typename T, typename Allocator>
+bool PooledIntervalTree<T, Allocator>::Remove(Interval<T> i)
+{
+  bool removed = false;
+  Root = Remove(Root, i, removed);
+  if(removed)
+  {
+    size--; // Decrement size on successful removal
+  }
+  return removed;
+}
+
+template <typename T, typename Allocator>
+bool PooledIntervalTree<T, Allocator>::Update(Interval<T> oldInterval, Interval<T> newInterval, std::shared_ptr<T> newData)
+{
+  bool found = Remove(oldInterval);
+  Insert(newInterval, newData); // Stored either way, as in IntervalTree::Update
+  return found;
+}
+
+template <typename T, typename Allocator>
+std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > PooledIntervalTree<T, Allocator>::Containing(T value) const
+{
+  std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > result;
+  FindContaining(Root, value, result);
+  return result;
+}
+
+template <typename T, typename Allocator>
+std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > PooledIntervalTree<T, Allocator>::Overlapping(T low, T high) const
+{
+  std::vector<std::pair<Interval<T>, std::shared_ptr<T> > > result;
+  FindOverlapping(Root, low, high, result);
+  return result;
+}
+
+template <typename T, typename Allocator>
+T PooledIntervalTree<T, Allocator>::MaxHighOverlapping(T low, T high) const
+{
+  T maxValue = IntervalKeyTraits<T>::Lowest();
+  MaxHighOverlapping(Root, low, high, maxValue);
+  return maxValue;
+}
+
+template <typename T, typename Allocator>
+bool PooledIntervalTree<T, Allocator>::Contains(T value) const
+{
+  return Overlaps(Root, value, value);
+}
+
+template <typename T, typename Allocator>
+bool PooledIntervalTree<T, Allocator>::Overlaps(T low, T high) const
+{
+  return Overlaps(Root, low, high);
+}
+
+template <typename T, typename Allocator>
+void PooledIntervalTree<T, Allocator>::Clear()
+{
+  pool.Clear(); // Every node lives in the pool, so there is no per-node teardown.
+  Root = NodeType::Null;
+  size = 0;
+}
+
+template <typename T, typename Allocator>
+std::future<void> PooledIntervalTree<T, Allocator>::ClearAsync()
+{
+  NodePool<NodeType, Allocator> old(std::move(pool));
+  pool.Clear(); // A moved-from vector is only guaranteed to be valid, not empty
+  Root = NodeType::Null;
+  size = 0;
+
+  // The parameter takes over the storage and dies when the task returns, on the worker thread
+  return std::async(std::launch::async, [](NodePool<NodeType, Allocator> storage) { (void)storage; }, std::move(old));
+}
+
+template <typename T, typename Allocator>
+void PooledIntervalTree<T, Allocator>::Reserve(size_t count)
+{
+  pool.Reserve(count);
+}
+
+template <typename T, typename Allocator>
+size_t PooledIntervalTree<T, Allocator>::Size() const
+{
+  return size;
+}
+
+template <typename T, typename Allocator>
+bool PooledIntervalTree<T, Allocator>::IsEmpty() const
+{
+  return Root == NodeType::Null;
+}
+
+template <typename T, typename Allocator>
+std::string PooledIntervalTree<T, Allocator>::ToString() const
+{
+  std::ostringstream oss;
+  ToString(Root, oss);
+  return oss.str();
+}
+
+template <typename T, typename Allocator>
+size_t PooledIntervalTree<T, Allocator>::MemoryUsage() const
+{
+  return pool.MemoryUsage();
+}
+
+template <typename T, typename Allocator>
+uint32_t PooledIntervalTree<T, Allocator>::Insert(uint32_t node, Interval<T> i, const std::shared_ptr<T>& data)
+{
+  if(node == NodeType::Null)
+  {
+    uint32_t leaf = pool.Allocate(i);
+    pool.Data(leaf) = data;
+    return leaf;
+  }
+
+  // The pool may grow during the recursive call, so the child index is stored
+  // through a fresh lookup rather than a reference taken before the call.
+  if(i.low < pool[node].interval.low)
+  {
+    uint32_t child = Insert(pool[node].left, i, data);
+    pool[node].left = child;
+  }
+  else
+  {
+    uint32_t child = Insert(pool[node].right, i, data);
+    pool[node].right = child;
+  }
+
+  return Rebalance(node);
+}
+
+template <typename T, typename Allocator>
+uint32_t PooledIntervalTree<T, Allocator>::Remove(uint32_t node, const Interval<T>& i, bool& removed)
+{
+  if(node == NodeType::Null)
+  {
+    return NodeType::Null;
+  }
+
+  NodeType& n = pool[node];
+  if(i.low < n.interval.low)
+  {
+    n.left = Remove(n.left, i, removed);
+  }
+  else if(i.low > n.interval.low)
+  {
+    n.right = Remove(n.right, i, removed);
+  }
+  else if(i.high != n.interval.high)
+  {
+    // Intervals sharing a low bound can end up on either side after rotations
+    n.left = Remove(n.left, i, removed);
+    if(!removed)
+    {
+      n.right = Remove(n.right, i, removed);
+    }
+  }
+  else
+  {
+    removed = true;
+    if(n.left == NodeType::Null || n.right == NodeType::Null)
+    {
+      uint32_t child = (n.left != NodeType::Null) ? n.left : n.right;
+      pool.Release(node);
+      return child;
+    }
+
+    // Node with two children: take over the in-order successor and unlink it
+    uint32_t successor = n.right;
+    while(pool[successor].left != NodeType::Null)
+    {
+      successor = pool[successor].left;
+    }
+    n.interval = pool[successor].interval;
+    pool.Data(node) = pool.Data(successor);
+    n.right = RemoveMin(n.right);
+  }
+
+  return Rebalance(node);
+}
+
+template <typename T, typename Allocator>
+uint32_t PooledIntervalTree<T, Allocator>::RemoveMin(uint32_t node)
+{
+  NodeType& n = pool[node];
+  if(n.left == NodeType::Null)
+  {
+    uint32_t right = n.right;
+    pool.Release(node);
+    return right;
+  }
+  n.left = RemoveMin(n.left);
+  return Rebalance(node);
+}
+
+template <typename T, typename Allocator>
+void PooledIntervalTree<T, Allocator>::UpdateMax(uint32_t node)
+{
+  NodeType& n = pool[node];
+  n.max = n.interval.high;
+  if(n.left != NodeType::Null)
+  {
+    n.max = std::max(n.max, pool[n.left].max);
+  }
+  if(n.right != NodeType::Null)
+  {
+    n.max = std::max(n.max, pool[n.right].max);
+  }
+  n.height = 1 + std::max(Height(n.left), Height(n.right));
+}
+
+template <typename T, typename Allocator>
+uint32_t PooledIntervalTree<T, Allocator>::Rebalance(uint32_t node)
+{
+  UpdateMax(node);
+
+  int balance = GetBalance(node);
+  if(balance > 1)
+  {
+    if(GetBalance(pool[node].left) < 0)
+    {
+      pool[node].left = RotateLeft(pool[node].left);
+    }
+    return RotateRight(node);
+  }
+  if(balance < -1)
+  {
+    if(GetBalance(pool[node].right) > 0)
+    {
+      pool[node].right = RotateRight(pool[node].right);
+    }
+    return RotateLeft(node);
+  }
+  return node;
+}
+
+template <typename T, typename Allocator>
+void PooledIntervalTree<T, Allocator>::FindContaining(uint32_t node, T value,
+  std::vector<std::pair<Interval<T>, std::shared_ptr<T> > >& result) const
+{
+  FindOverlapping(node, value, value, result);
+}
+
+template <typename T, typename Allocator>
+void PooledIntervalTree<T, Allocator>::FindOverlapping(uint32_t node, T low, T high,
+  std::vector<std::pair<Interval<T>, std::shared_ptr<T> > >& result) const
+{
+  if(node == NodeType::Null)
+  {
+    return;
+  }
+
+  const NodeType& n = pool[node];
+  pool.Prefetch(n.left);
+  pool.Prefetch(n.right);
+  if(n.interval.low <= high && n.interval.high >= low)
+  {
+    result.emplace_back(n.interval, pool.Data(node));
+  }
+
+  if(n.left != NodeType::Null && pool[n.left].max >= low)
+  {
+    FindOverlapping(n.left, low, high, result);
+  }
+
+  // Lows in the right subtree are at least n.interval.low, so it can only overlap if that is still <= high
+  if(n.interval.low <= high)
+  {
+    FindOverlapping(n.right, low, high, result);
+  }
+}
+
+template <typename T, typename Allocator>
+void PooledIntervalTree<T, Allocator>::MaxHighOverlapping(uint32_t node, T low, T high, T& maxValue) const
+{
+  if(node == NodeType::Null)
+  {
+    return;
+  }
+
+  const NodeType& n = pool[node];
+  pool.Prefetch(n.left);
+  pool.Prefetch(n.right);
+  if(n.interval.low <= high && n.interval.high >= low)
+  {
+    maxValue = std::max(maxValue, n.interval.high);
+  }
+
+  if(n.left != NodeType::Null && pool[n.left].max >= low)
+  {
+    MaxHighOverlapping(n.left, low, high, maxValue);
+  }
+
+  if(n.interval.low <= high)
+  {
+    MaxHighOverlapping(n.right, low, high, maxValue);
+  }
+}
+
+template <typename T, typename Allocator>
+bool PooledIntervalTree<T, Allocator>::Overlaps(uint32_t node, T low, T high) const
+{
+  while(node != NodeType::Null)
+  {
+    const NodeType& n = pool[node];
+    pool.Prefetch(n.right); // Requested while the left child's max is loaded, since either may come next
+    if(n.interval.low <= high && n.interval.high >= low)
+    {
+      return true;
+    }
+
+    // If the left subtree reaches low but holds no overlap, nothing to the right can overlap either
+    node = (n.left != NodeType::Null && pool[n.left].max >= low) ? n.left : n.right;
+  }
+  return false;
+}
+
+template <typename T, typename Allocator>
+int PooledIntervalTree<T, Allocator>::Height(uint32_t node) const
+{
+  return node != NodeType::Null ? pool[node].height : 0;
+}
+
+template <typename T, typename Allocator>
+int PooledIntervalTree<T, Allocator>::GetBalance(uint32_t node) const
+{
+  if(node == NodeType::Null)
+  {
+    return 0;
+  }
+  return Height(pool[node].left) - Height(pool[node].right);
+}
+
+template <typename T, typename Allocator>
+uint32_t PooledIntervalTree<T, Allocator>::RotateRight(uint32_t node)
+{
+  uint32_t newRoot = pool[node].left;
+  pool[node].left = pool[newRoot].right;
+  pool[newRoot].right = node;
+
+  // Update the max value of the rotated nodes
+  UpdateMax(node);
+  UpdateMax(newRoot);
+
+  return newRoot; // New root of the subtree
+}
+
+template <typename T, typename Allocator>
+uint32_t PooledIntervalTree<T, Allocator>::RotateLeft(uint32_t node)
+{
+  uint32_t newRoot = pool[node].right;
+  pool[node].right = pool[newRoot].left;
+  pool[newRoot].left = node;
+
+  // Update the max value of the rotated nodes
+  UpdateMax(node);
+  UpdateMax(newRoot);
+
+  return newRoot; // New root of the subtree
+}
+
+template <typename T, typename Allocator>
+void PooledIntervalTree<T, Allocator>::ToString(uint32_t node, std::ostringstream& oss) const
+{
+  if(node != NodeType::Null)
+  {
+    const NodeType& n = pool[node];
+    ToString(n.left, oss);
+    oss << "[" << n.interval.low << ", " << n.interval.high << "] ";
+    ToString(n.right, oss);
+  }
+}
+#endif
@@ -0,0 +1,480 @@
+//---------------------------------------------------------------------------
+
+#ifndef RectangleIndexH
+#define RectangleIndexH
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "IntervalTree.h"
+#include "IntervalSimd.h"
+
+/**
+ * @tparam T The type of the bounds.
+ * @struct Rectangle
+ * @brief Represents an axis-aligned rectangle as one closed interval per dimension.
+ */
+template <typename T>
+struct Rectangle
+{
+  Interval<T> x; ///< The extent along the first dimension, such as time.
+  Interval<T> y; ///< The extent along the second dimension, such as an address range.
+
+  constexpr Rectangle() : x(), y() {} ///< Constructs the rectangle [T(), T()] x [T(), T()].
+
+  /**
+   * @brief Constructs a rectangle from its extent in each dimension.
+   * @param x The extent along the first dimension.
+   * @param y The extent along the second dimension.
+   */
+  constexpr Rectangle(Interval<T> x, Interval<T> y) : x(x), y(y) {}
+
+  /**
+   * @brief Constructs a rectangle from its four bounds.
+   */
+  constexpr Rectangle(T xLow, T xHigh, T yLow, T yHigh) : x(xLow, xHigh), y(yLow, yHigh) {}
+};
+
+/**
+ * @tparam T The type of the bounds.
+ * @tparam V The type of the payload stored with each rectangle.
+ * @class RectangleIndex
+ * @brief An immutable two-dimensional index of rectangles: a packed R-tree of wide nodes, pruned on both dimensions at once.
+ *
+ * Intersecting the Overlapping() results of one IntervalTree per dimension
+ * collects every rectangle that meets the query in either dimension before it
+ * can drop the ones that miss in the other. This index keeps both extents of
+ * each rectangle together, so a single descent skips any subtree whose box
+ * misses the query in x or in y.
+ *
+ * The rectangles are ordered by Sort-Tile-Recursive packing: each node's
+ * rectangles are sorted by x low and cut into vertical slices, each slice
+ * is sorted by y low and cut into its children, and the children are packed
+ * the same way in turn. Every node except those on the right edge is full, so
+ * the layout is the implicit one of WideIntervalIndex. Leaves are blocks of
+ * IntervalSimd::Width rectangles, each internal node stores the bounding boxes
+ * of up to Width children, and the four bounds sit in separate
+ * cache-line-aligned arrays. One OverlapMask call per dimension then tests a
+ * whole node against the query.
+ *
+ * The index is built once from a range. Concurrent queries are safe.
+ */
+template <typename T = int, typename V = std::shared_ptr<T> >
+class RectangleIndex
+{
+  public:
+    RectangleIndex() : count(0) {} ///< Constructs an empty index.
+
+    /**
+     * @brief Builds an index from a range of rectangles in O(n log^2 n).
+     * @param first The beginning of the range of Rectangle<T> or std::pair<Rectangle<T>, V> elements.
+     * @param last The end of the range.
+     * @throws std::invalid_argument if a rectangle has low > high in either dimension.
+     */
+    template <typename Iter>
+    RectangleIndex(Iter first, Iter last);
+
+    /**
+     * @brief Finds all rectangles that contain a specific point.
+     * @param x The coordinate of the point along the first dimension.
+     * @param y The coordinate of the point along the second dimension.
+     * @return A vector of rectangles that contain the specified point.
+     */
+    std::vector<std::pair<Rectangle<T>, V> > Containing(T x, T y) const;
+
+    /**
+     * @brief Finds all rectangles that overlap with a given query rectangle.
+     * @param x The extent of the query along the first dimension.
+     * @param y The extent of the query along the second dimension.
+     * @return A vector of rectangles that overlap with the query in both dimensions.
+     */
+    std::vector<std::pair<Rectangle<T>, V> > Overlapping(Interval<T> x, Interval<T> y) const;
+
+    /**
+     * @brief Calls a visitor for every rectangle that overlaps with a given query rectangle.
+     * @param x The extent of the query along the first dimension.
+     * @param y The extent of the query along the second dimension.
+     * @param visit The callable invoked as visit(const Rectangle<T>&, const V&); returning false stops the query.
+     */
+    template <typename Visitor>
+    void ForEachOverlapping(Interval<T> x, Interval<T> y, Visitor visit) const;
+
+    /**
+     * @brief Counts the rectangles that overlap with a given query rectangle.
+     * @param x The extent of the query along the first dimension.
+     * @param y The extent of the query along the second dimension.
+     * @return The number of overlapping rectangles.
+     */
+    size_t CountOverlapping(Interval<T> x, Interval<T> y) const;
+
+    /**
+     * @brief Checks if a specific point is contained within any rectangle.
+     * @param x The coordinate of the point along the first dimension.
+     * @param y The coordinate of the point along the second dimension.
+     * @return True if the point is contained in any rectangle, false otherwise.
+     */
+    bool Contains(T x, T y) const;
+
+    /**
+     * @brief Checks if any rectangles overlap with a given query rectangle.
+     * @param x The extent of the query along the first dimension.
+     * @param y The extent of the query along the second dimension.
+     * @return True if there are overlapping rectangles, false otherwise.
+     */
+    bool Overlaps(Interval<T> x, Interval<T> y) const;
+
+    /**
+     * @brief Checks whether the index is empty.
+     * @return True if the index holds no rectangles, false otherwise.
+     */
+    bool IsEmpty(void) const;
+
+    /**
+     * @brief Gets the number of rectangles in the index.
+     * @return The number of rectangles in the index.
+     */
+    size_t Size() const;
+
+    /**
+     * @brief Gets the number of levels, the leaf blocks included.
+     * @return The depth of every descent, 0 for an empty index.
+     */
+    size_t Depth() const;
+
+  private:
+    typedef IntervalKeyTraits<T> Traits;
+    typedef typename Traits::Key Key; ///< Integral keys are widened to 32 or 64 bits so the SIMD kernels apply.
+    typedef std::vector<Key, IntervalSimd::AlignedAllocator<Key> > KeyArray;
+    typedef std::pair<Rectangle<T>, V> Entry;
+
+    /**
+     * @brief The four bounds of a sequence of boxes, one array per bound, padded to whole blocks.
+     */
+    struct Boxes
+    {
+      KeyArray xLows; ///< The lowest x of each box.
+      KeyArray xHighs; ///< The highest x of each box.
+      KeyArray yLows; ///< The lowest y of each box.
+      KeyArray yHighs; ///< The highest y of each box.
+
+      /**
+       * @brief Sets every bound to Key(), for size boxes.
+       */
+      void Assign(size_t size)
+      {
+        xLows.assign(size, Key());
+        xHighs.assign(size, Key());
+        yLows.assign(size, Key());
+        yHighs.assign(size, Key());
+      }
+
+      /**
+       * @brief Finds the boxes of the block at base that overlap the query in both dimensions.
+       */
+      unsigned Mask(size_t base, Key xLow, Key xHigh, Key yLow, Key yHigh) const
+      {
+        return IntervalSimd::OverlapMask(&xLows[base], &xHighs[base], xLow, xHigh) &
+               IntervalSimd::OverlapMask(&yLows[base], &yHighs[base], yLow, yHigh);
+      }
+    };
+
+    /**
+     * @brief One level of internal nodes: the bounding boxes of the nodes or leaf blocks below, Width per node.
+     */
+    struct Level
+    {
+      Boxes boxes; ///< The bounding box of each child.
+      size_t children; ///< The number of valid child boxes; the rest of the last node is padding.
+    };
+
+    Boxes leaves; ///< The rectangles in packing order, padded to whole blocks.
+    std::vector<V> data; ///< The data of each rectangle, kept apart from the search keys.
+    std::vector<Level> levels; ///< Internal levels, from the one above the leaves up to the single root node.
+    size_t count; ///< The number of rectangles.
+
+    static const int MaxLevels = 24; ///< 8^22 exceeds any size_t count, so the traversal stack never overflows.
+
+    /**
+     * @brief Packs entries into leaf blocks and builds the levels above them.
+     */
+    void Build(std::vector<Entry>& entries);
+
+    /**
+     * @brief Orders the entries of one node so that each run of capacity entries is a compact tile.
+     * @param capacity The number of entries under each child of the node.
+     */
+    static void Tile(std::vector<Entry>& entries, size_t begin, size_t end, size_t capacity);
+
+    /**
+     * @brief Masks off the lanes of a block at or past the end of its array.
+     */
+    static unsigned Valid(size_t begin, size_t end)
+    {
+      return end - begin >= IntervalSimd::Width ? (1u << IntervalSimd::Width) - 1 : (1u << (end - begin)) - 1;
+    }
+
+    /**
+     * @brief Visits overlapping rectangles with a given query rectangle.
+     * @return False if the visitor stopped the query.
+     */
+    template <typename Visitor>
+    bool FindOverlapping(const Interval<T>& x, const Interval<T>& y, Visitor& visit) const;
+
+    /**
+     * @brief Converts a bulk-load element to an index entry.
+     */
+    static Entry MakeEntry(const Rectangle<T>& r)
+    {
+      return std::make_pair(r, V());
+    }
+
+    /**
+     * @brief Converts a bulk-load element to an index entry.
+     */
+    static Entry MakeEntry(const Entry& entry)
+    {
+      return entry;
+    }
+};
+
+
+template <typename T, typename V>
+template <typename Iter>
+RectangleIndex<T, V>::RectangleIndex(Iter first, Iter last) : count(0)
+{
+  std::vector<Entry> entries;
+  for(; first != last; ++first)
+  {
+    entries.push_back(MakeEntry(*first));
+    const Rectangle<T>& r = entries.back().first;
+    if(r.x.low > r.x.high || r.y.low > r.y.high)
+    {
+      throw std::invalid_argument("Invalid rectangle: low must be less than or equal to high in both dimensions.");
+    }
+  }
+  Build(entries);
+}
+
+template <typename T, typename V>
+std::vector<std::pair<Rectangle<T>, V> > RectangleIndex<T, V>::Containing(T x, T y) const
+{
+  return Overlapping(Interval<T>(x, x), Interval<T>(y, y));
+}
+
+template <typename T, typename V>
+std::vector<std::pair<Rectangle<T>, V> > RectangleIndex<T, V>::Overlapping(Interval<T> x, Interval<T> y) const
+{
+  std::vector<Entry> result;
+  ForEachOverlapping(x, y, [&result](const Rectangle<T>& r, const V& payload)
+  {
+    result.emplace_back(r, payload);
+  });
+  return result;
+}
+
+template <typename T, typename V>
+template <typename Visitor>
+void RectangleIndex<T, V>::ForEachOverlapping(Interval<T> x, Interval<T> y, Visitor visit) const
+{
+  FindOverlapping(x, y, visit);
+}
+
+template <typename T, typename V>
+size_t RectangleIndex<T, V>::CountOverlapping(Interval<T> x, Interval<T> y) const
+{
+  size_t found = 0;
+  auto each = [&found](const Rectangle<T>&, const V&)
+  {
+    ++found;
+  };
+  FindOverlapping(x, y, each);
+  return found;
+}
+
+template <typename T, typename V>
+bool RectangleIndex<T, V>::Contains(T x, T y) const
+{
+  return Overlaps(Interval<T>(x, x), Interval<T>(y, y));
+}
+
+template <typename T, typename V>
+bool RectangleIndex<T, V>::Overlaps(Interval<T> x, Interval<T> y) const
+{
+  bool found = false;
+  auto stop = [&found](const Rectangle<T>&, const V&)
+  {
+    found = true;
+    return false;
+  };
+  FindOverlapping(x, y, stop);
+  return found;
+}
+
+template <typename T, typename V>
+bool RectangleIndex<T, V>::IsEmpty() const
+{
+  return count == 0;
+}
+
+template <typename T, typename V>
+size_t RectangleIndex<T, V>::Size() const
+{
+  return count;
+}
+
+template <typename T, typename V>
+size_t RectangleIndex<T, V>::Depth() const
+{
+  return count == 0 ? 0 : levels.size() + 1;
+}
+
+template <typename T, typename V>
+void RectangleIndex<T, V>::Build(std::vector<Entry>& entries)
+{
+  const size_t width = IntervalSimd::Width;
+  count = entries.size();
+  if(count == 0)
+  {
+    return;
+  }
+
+  // The root has at most Width children, each over the smallest power of Width that lets them hold everything
+  size_t capacity = 1;
+  while(capacity * width < count)
+  {
+    capacity *= width;
+  }
+  Tile(entries, 0, count, capacity);
+
+  // Padding lanes keep Key() and are masked off by Valid, so no sentinel key is needed
+  size_t blocks = (count + width - 1) / width;
+  leaves.Assign(blocks * width);
+  data.reserve(count);
+  for(size_t n = 0; n < count; ++n)
+  {
+    const Rectangle<T>& r = entries[n].first;
+    leaves.xLows[n] = Traits::Encode(r.x.low);
+    leaves.xHighs[n] = Traits::Encode(r.x.high);
+    leaves.yLows[n] = Traits::Encode(r.y.low);
+    leaves.yHighs[n] = Traits::Encode(r.y.high);
+    data.push_back(std::move(entries[n].second));
+  }
+
+  // Box the leaf blocks, then each level of nodes, until one node covers everything
+  size_t children = blocks;
+  const Boxes* below = &leaves;
+  size_t belowCount = count;
+  do
+  {
+    Level level;
+    size_t nodes = (children + width - 1) / width;
+    level.boxes.Assign(nodes * width);
+    level.children = children;
+    for(size_t c = 0; c < children; ++c)
+    {
+      size_t begin = c * width;
+      size_t end = std::min(begin + width, belowCount);
+      level.boxes.xLows[c] = *std::min_element(below->xLows.begin() + begin, below->xLows.begin() + end);
+      level.boxes.xHighs[c] = *std::max_element(below->xHighs.begin() + begin, below->xHighs.begin() + end);
+      level.boxes.yLows[c] = *std::min_element(below->yLows.begin() + begin, below->yLows.begin() + end);
+      level.boxes.yHighs[c] = *std::max_element(below->yHighs.begin() + begin, below->yHighs.begin() + end);
+    }
+    levels.push_back(std::move(level));
+    below = &levels.back().boxes;
+    belowCount = children;
+    children = nodes;
+  } while(children > 1);
+}
+
+template <typename T, typename V>
+void RectangleIndex<T, V>::Tile(std::vector<Entry>& entries, size_t begin, size_t end, size_t capacity)
+{
+  if(capacity == 1)
+  {
+    return; // The children are single rectangles, whose order within a leaf block does not matter
+  }
+
+  // Cut the node into about sqrt(k) slices of sqrt(k) children each, so its children come out close to square
+  size_t children = (end - begin + capacity - 1) / capacity;
+  size_t slices = 1;
+  while(slices * slices < children)
+  {
+    ++slices;
+  }
+  const size_t slice = slices * capacity;
+
+  std::sort(entries.begin() + begin, entries.begin() + end, [](const Entry& a, const Entry& b)
+  {
+    return a.first.x.low < b.first.x.low;
+  });
+  for(size_t start = begin; start < end; start += slice)
+  {
+    size_t stop = std::min(start + slice, end);
+    std::sort(entries.begin() + start, entries.begin() + stop, [](const Entry& a, const Entry& b)
+    {
+      return a.first.y.low < b.first.y.low;
+    });
+    for(size_t child = start; child < stop; child += capacity)
+    {
+      Tile(entries, child, std::min(child + capacity, stop), capacity / IntervalSimd::Width);
+    }
+  }
+}
+
+template <typename T, typename V>
+template <typename Visitor>
+bool RectangleIndex<T, V>::FindOverlapping(const Interval<T>& x, const Interval<T>& y, Visitor& visit) const
+{
+  if(count == 0)
+  {
+    return true;
+  }
+
+  const size_t width = IntervalSimd::Width;
+  const Key xLow = Traits::Encode(x.low);
+  const Key xHigh = Traits::Encode(x.high);
+  const Key yLow = Traits::Encode(y.low);
+  const Key yHigh = Traits::Encode(y.high);
+  std::pair<size_t, size_t> stack[MaxLevels * IntervalSimd::Width]; // (level, node)
+  int top = 0;
+  stack[top++] = std::make_pair(levels.size() - 1, size_t(0));
+
+  while(top > 0)
+  {
+    std::pair<size_t, size_t> entry = stack[--top];
+    const Level& level = levels[entry.first];
+    size_t base = entry.second * width;
+    unsigned mask = level.boxes.Mask(base, xLow, xHigh, yLow, yHigh) & Valid(base, level.children);
+
+    if(entry.first == 0)
+    {
+      // The children are leaf blocks: test their rectangles right away
+      for(; mask; mask &= mask - 1)
+      {
+        size_t block = (base + IntervalSimd::LowestBit(mask)) * width;
+        unsigned hits = leaves.Mask(block, xLow, xHigh, yLow, yHigh) & Valid(block, count);
+        for(; hits; hits &= hits - 1)
+        {
+          size_t n = block + IntervalSimd::LowestBit(hits);
+          Rectangle<T> r(Traits::Decode(leaves.xLows[n]), Traits::Decode(leaves.xHighs[n]),
+                         Traits::Decode(leaves.yLows[n]), Traits::Decode(leaves.yHighs[n]));
+          if(!IntervalTreeDetail::Visit(visit, r, data[n]))
+          {
+            return false;
+          }
+        }
+      }
+      continue;
+    }
+
+    for(; mask; mask &= mask - 1)
+    {
+      stack[top++] = std::make_pair(entry.first - 1, base + IntervalSimd::LowestBit(mask));
+    }
+  }
+  return true;
+}
+#endif
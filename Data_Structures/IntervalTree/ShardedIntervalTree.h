@@ -0,0 +1,386 @@
+//---------------------------------------------------------------------------
+
+#ifndef ShardedIntervalTreeH
+#define ShardedIntervalTreeH
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "IntervalTree.h"
+#include "IntervalSimd.h"
+
+/**
+ * @tparam T The type of the interval bounds.
+ * @tparam V The type of the payload stored with each interval.
+ * @tparam A The augmentation policy of each shard.
+ * @class ShardedIntervalTree
+ * @brief An interval tree split into key-range shards, each with its own lock, so writers on different shards run in parallel.
+ *
+ * The boundaries b[0] < b[1] < ... < b[N - 2] cut the key space into N
+ * shards: shard k holds the keys in [b[k - 1], b[k]). An interval whose low
+ * and high fall in the same shard lives in that shard's IntervalTree. An
+ * interval that crosses a boundary lives in a separate spanning tree, which
+ * has a lock of its own as well. Choose the boundaries so that writes spread
+ * evenly over the shards and few intervals cross them, for example from
+ * quantiles of a sample; the spanning tree is shared by every writer.
+ *
+ * A writer locks only the tree it changes. A query visits the shards its
+ * range reaches, plus the spanning tree, and never holds a lock while it
+ * searches: it takes an O(1) snapshot of each tree under that tree's lock,
+ * queries the snapshot, and releases it under the lock again. Each shard is
+ * therefore seen at one point in time, but different shards may be seen at
+ * different times. Hits come in no particular order.
+ */
+template <typename T = int, typename V = std::shared_ptr<T>, typename A = NoAugmentation>
+class ShardedIntervalTree
+{
+  public:
+    /**
+     * @brief Constructs an empty tree with one shard more than there are boundaries.
+     * @param boundaries The lowest key of every shard but the first, in strictly ascending order.
+     * @throws std::invalid_argument if the boundaries are not strictly ascending.
+     */
+    explicit ShardedIntervalTree(std::vector<T> boundaries);
+
+    ShardedIntervalTree(const ShardedIntervalTree&) = delete;
+    ShardedIntervalTree& operator=(const ShardedIntervalTree&) = delete;
+
+    void Insert(T low, T high, V data = V()); ///< Inserts a new interval into its shard, which may be the spanning tree.
+    void Insert(Interval<T> i, V data = V()); ///< Inserts a new interval into its shard, which may be the spanning tree.
+
+    /**
+     * @brief Removes an interval whose bounds both match.
+     * @param i The interval to remove.
+     * @return True if an interval was removed, false if none matched.
+     */
+    bool Remove(Interval<T> i);
+
+    /**
+     * @brief Finds all intervals that contain a specific value.
+     * @param value The value to check for containment.
+     * @return A vector of intervals that contain the specified value.
+     */
+    std::vector<std::pair<Interval<T>, V> > Containing(T value) const;
+
+    /**
+     * @brief Finds all intervals that overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return A vector of intervals that overlap with the specified range.
+     */
+    std::vector<std::pair<Interval<T>, V> > Overlapping(T low, T high) const;
+
+    /**
+     * @brief Calls a visitor for every interval that overlaps with a given range.
+     *
+     * The visitor runs outside every lock, so it may call the writer methods of the same tree.
+     *
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @param visit The callable invoked as visit(const Interval<T>&, const V&); returning false stops the query.
+     */
+    template <typename Visitor>
+    void ForEachOverlapping(T low, T high, Visitor visit) const;
+
+    /**
+     * @brief Counts the intervals that overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return The number of overlapping intervals.
+     */
+    size_t CountOverlapping(T low, T high) const;
+
+    /**
+     * @brief Checks if a specific value is contained within any interval.
+     * @param value The value to check.
+     * @return True if the value is contained in any interval, false otherwise.
+     */
+    bool Contains(T value) const;
+
+    /**
+     * @brief Checks if any intervals overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return True if there are overlapping intervals, false otherwise.
+     */
+    bool Overlaps(T low, T high) const;
+
+    void Clear(void); ///< Removes all intervals from every shard.
+
+    /**
+     * @brief Checks whether the tree is empty.
+     * @return True if no shard holds an interval, false otherwise.
+     */
+    bool IsEmpty(void) const;
+
+    /**
+     * @brief Gets the number of intervals, summed over the shards one at a time.
+     * @return The number of intervals.
+     */
+    size_t Size() const;
+
+    /**
+     * @brief Gets the number of key-range shards, the spanning tree not included.
+     * @return The number of boundaries plus one.
+     */
+    size_t Shards() const;
+
+    /**
+     * @brief Gets the number of intervals that cross a boundary and live in the spanning tree.
+     * @return The size of the spanning tree.
+     */
+    size_t Spanning() const;
+
+  private:
+    /**
+     * @brief One tree and the lock that guards it, on cache lines of its own so writers on neighbouring shards do not contend.
+     */
+    struct alignas(IntervalSimd::CacheLine) Shard
+    {
+      mutable std::mutex lock; ///< Guards tree.
+      IntervalTree<T, V, A> tree; ///< The intervals of the shard.
+    };
+
+    std::vector<T> boundaries; ///< The lowest key of every shard but the first.
+    std::vector<Shard, IntervalSimd::AlignedAllocator<Shard> > shards; ///< The key-range shards in ascending order of key, then the spanning tree.
+
+    /**
+     * @brief Finds the shard whose key range holds value.
+     */
+    size_t ShardOf(T value) const
+    {
+      return static_cast<size_t>(std::upper_bound(boundaries.begin(), boundaries.end(), value) - boundaries.begin());
+    }
+
+    /**
+     * @brief Finds the tree an interval belongs in.
+     */
+    Shard& Home(const Interval<T>& i)
+    {
+      size_t first = ShardOf(i.low);
+      return first == ShardOf(i.high) ? shards[first] : shards.back();
+    }
+
+    /**
+     * @brief A snapshot of one shard's tree, taken and released under the shard's lock.
+     *
+     * A writer modifies a node in place when its use_count() says no other
+     * version shares it, and orders that check with an acquire fence.
+     * ThreadSanitizer does not model fences, so the snapshot still lets go of
+     * its nodes under the same lock the writer holds, which keeps sanitized
+     * builds quiet; only the search between the two runs unlocked.
+     */
+    class Pinned
+    {
+      public:
+        explicit Pinned(const Shard& shard) : shard(shard), tree(Snapshot(shard)) {}
+        ~Pinned()
+        {
+          std::lock_guard<std::mutex> lock(shard.lock);
+          tree.Clear();
+        }
+
+        Pinned(const Pinned&) = delete;
+        Pinned& operator=(const Pinned&) = delete;
+
+        const IntervalTree<T, V, A>& Tree() const { return tree; } ///< Gets the snapshot.
+
+      private:
+        const Shard& shard; ///< The shard the snapshot was taken from.
+        IntervalTree<T, V, A> tree; ///< The snapshot.
+
+        static IntervalTree<T, V, A> Snapshot(const Shard& shard)
+        {
+          std::lock_guard<std::mutex> lock(shard.lock);
+          return shard.tree;
+        }
+    };
+
+    /**
+     * @brief Visits overlapping intervals in every tree the range reaches.
+     * @return False if the visitor stopped the query.
+     */
+    template <typename Visitor>
+    bool FindOverlapping(T low, T high, Visitor& visit) const;
+};
+
+
+template <typename T, typename V, typename A>
+ShardedIntervalTree<T, V, A>::ShardedIntervalTree(std::vector<T> bounds)
+  : boundaries(std::move(bounds)), shards(boundaries.size() + 2)
+{
+  for(size_t n = 1; n < boundaries.size(); ++n)
+  {
+    if(!(boundaries[n - 1] < boundaries[n]))
+    {
+      throw std::invalid_argument("Invalid shard boundaries: they must be strictly ascending.");
+    }
+  }
+}
+
+template <typename T, typename V, typename A>
+void ShardedIntervalTree<T, V, A>::Insert(T low, T high, V data)
+{
+  Insert(Interval<T>(low, high), std::move(data));
+}
+
+template <typename T, typename V, typename A>
+void ShardedIntervalTree<T, V, A>::Insert(Interval<T> i, V data)
+{
+  if(i.low > i.high)
+  {
+    throw std::invalid_argument("Invalid interval: low must be less than or equal to high.");
+  }
+  Shard& shard = Home(i);
+  std::lock_guard<std::mutex> lock(shard.lock);
+  shard.tree.Insert(i, std::move(data));
+}
+
+template <typename T, typename V, typename A>
+bool ShardedIntervalTree<T, V, A>::Remove(Interval<T> i)
+{
+  if(i.low > i.high)
+  {
+    return false; // Could never have been inserted
+  }
+  Shard& shard = Home(i);
+  std::lock_guard<std::mutex> lock(shard.lock);
+  return shard.tree.Remove(i);
+}
+
+template <typename T, typename V, typename A>
+std::vector<std::pair<Interval<T>, V> > ShardedIntervalTree<T, V, A>::Containing(T value) const
+{
+  return Overlapping(value, value);
+}
+
+template <typename T, typename V, typename A>
+std::vector<std::pair<Interval<T>, V> > ShardedIntervalTree<T, V, A>::Overlapping(T low, T high) const
+{
+  std::vector<std::pair<Interval<T>, V> > result;
+  auto collect = [&result](const Interval<T>& i, const V& payload)
+  {
+    result.emplace_back(i, payload);
+  };
+  FindOverlapping(low, high, collect);
+  return result;
+}
+
+template <typename T, typename V, typename A>
+template <typename Visitor>
+void ShardedIntervalTree<T, V, A>::ForEachOverlapping(T low, T high, Visitor visit) const
+{
+  FindOverlapping(low, high, visit);
+}
+
+template <typename T, typename V, typename A>
+size_t ShardedIntervalTree<T, V, A>::CountOverlapping(T low, T high) const
+{
+  if(low > high)
+  {
+    return 0;
+  }
+  size_t found = Pinned(shards.back()).Tree().CountOverlapping(low, high);
+  for(size_t k = ShardOf(low), last = ShardOf(high); k <= last; ++k)
+  {
+    found += Pinned(shards[k]).Tree().CountOverlapping(low, high);
+  }
+  return found;
+}
+
+template <typename T, typename V, typename A>
+bool ShardedIntervalTree<T, V, A>::Contains(T value) const
+{
+  return Overlaps(value, value);
+}
+
+template <typename T, typename V, typename A>
+bool ShardedIntervalTree<T, V, A>::Overlaps(T low, T high) const
+{
+  if(low > high)
+  {
+    return false;
+  }
+  for(size_t k = ShardOf(low), last = ShardOf(high); k <= last; ++k)
+  {
+    if(Pinned(shards[k]).Tree().Overlaps(low, high))
+    {
+      return true;
+    }
+  }
+  return Pinned(shards.back()).Tree().Overlaps(low, high);
+}
+
+template <typename T, typename V, typename A>
+void ShardedIntervalTree<T, V, A>::Clear()
+{
+  for(size_t k = 0; k < shards.size(); ++k)
+  {
+    std::lock_guard<std::mutex> lock(shards[k].lock);
+    shards[k].tree.Clear();
+  }
+}
+
+template <typename T, typename V, typename A>
+bool ShardedIntervalTree<T, V, A>::IsEmpty() const
+{
+  return Size() == 0;
+}
+
+template <typename T, typename V, typename A>
+size_t ShardedIntervalTree<T, V, A>::Size() const
+{
+  size_t total = 0;
+  for(size_t k = 0; k < shards.size(); ++k)
+  {
+    std::lock_guard<std::mutex> lock(shards[k].lock);
+    total += shards[k].tree.Size();
+  }
+  return total;
+}
+
+template <typename T, typename V, typename A>
+size_t ShardedIntervalTree<T, V, A>::Shards() const
+{
+  return shards.size() - 1;
+}
+
+template <typename T, typename V, typename A>
+size_t ShardedIntervalTree<T, V, A>::Spanning() const
+{
+  std::lock_guard<std::mutex> lock(shards.back().lock);
+  return shards.back().tree.Size();
+}
+
+template <typename T, typename V, typename A>
+template <typename Visitor>
+bool ShardedIntervalTree<T, V, A>::FindOverlapping(T low, T high, Visitor& visit) const
+{
+  if(low > high)
+  {
+    return true;
+  }
+
+  bool more = true;
+  auto inner = [&visit, &more](const Interval<T>& i, const V& payload)
+  {
+    more = IntervalTreeDetail::Visit(visit, i, payload);
+    return more;
+  };
+
+  // An interval that overlaps the range holds a key of it, so unless it spans shards it sits in one of these
+  for(size_t k = ShardOf(low), last = ShardOf(high); k <= last && more; ++k)
+  {
+    Pinned(shards[k]).Tree().ForEachOverlapping(low, high, inner);
+  }
+  if(more)
+  {
+    Pinned(shards.back()).Tree().ForEachOverlapping(low, high, inner);
+  }
+  return more;
+}
+#endif
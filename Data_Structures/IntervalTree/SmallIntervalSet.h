@@ -0,0 +1,294 @@
+//---------------------------------------------------------------------------
+
+#ifndef SmallIntervalSetH
+#define SmallIntervalSetH
+
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "IntervalTree.h"
+#include "IntervalSimd.h"
+
+/**
+ * @tparam T The type of the interval bounds.
+ * @tparam V The type of the payload stored with each interval.
+ * @tparam A The augmentation policy of the tree used once the set grows large.
+ * @class SmallIntervalSet
+ * @brief An interval set that scans flat arrays while small and moves into an IntervalTree when it grows.
+ *
+ * Up to about a hundred intervals, one pass over packed lows and highs beats a
+ * pointer walk: every block of IntervalSimd::Width intervals costs one SIMD
+ * compare, and the resulting mask says which lanes to copy out. Inserts
+ * append and removes swap the last interval into the hole, so small-mode
+ * queries return hits in no particular order.
+ *
+ * When an insert takes the set past the threshold, its intervals are bulk
+ * loaded into an IntervalTree and it carries on as a tree. It switches back
+ * once removes bring it down to half the threshold, so a set that hovers
+ * around the threshold does not rebuild on every change.
+ */
+template <typename T = int, typename V = std::shared_ptr<T>, typename A = NoAugmentation>
+class SmallIntervalSet
+{
+  public:
+    static const size_t DefaultThreshold = 128; ///< Where an AVX2 int scan stops keeping up with a cache-hot tree.
+
+    /**
+     * @brief Constructs an empty set.
+     * @param threshold The size above which the set switches to an IntervalTree.
+     */
+    explicit SmallIntervalSet(size_t threshold = DefaultThreshold) : threshold(threshold), large(false) {}
+
+    void Insert(T low, T high, V data = V()); ///< Inserts a new interval into the set.
+    void Insert(Interval<T> i, V data = V()); ///< Inserts a new interval into the set.
+
+    /**
+     * @brief Removes one interval with exactly these bounds.
+     * @param i The interval to remove.
+     * @return True if an interval was removed, false if none matched.
+     */
+    bool Remove(Interval<T> i);
+
+    /**
+     * @brief Finds all intervals that contain a specific value.
+     * @param value The value to check for containment.
+     * @return A vector of intervals that contain the specified value.
+     */
+    std::vector<std::pair<Interval<T>, V> > Containing(T value) const;
+
+    /**
+     * @brief Finds all intervals that overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return A vector of intervals that overlap with the specified range.
+     */
+    std::vector<std::pair<Interval<T>, V> > Overlapping(T low, T high) const;
+
+    /**
+     * @brief Calls a visitor for every interval that overlaps with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @param visit The callable invoked as visit(const Interval<T>&, const V&); returning false stops the query.
+     */
+    template <typename Visitor>
+    void ForEachOverlapping(T low, T high, Visitor visit) const;
+
+    /**
+     * @brief Checks if a specific value is contained within any interval.
+     * @param value The value to check.
+     * @return True if the value is contained in any interval, false otherwise.
+     */
+    bool Contains(T value) const;
+
+    /**
+     * @brief Checks if any intervals overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return True if there are overlapping intervals, false otherwise.
+     */
+    bool Overlaps(T low, T high) const;
+
+    void Clear(void); ///< Removes all intervals and returns to the flat layout.
+
+    /**
+     * @brief Checks whether the set is empty.
+     * @return True if the set holds no intervals, false otherwise.
+     */
+    bool IsEmpty(void) const;
+
+    /**
+     * @brief Gets the number of intervals in the set.
+     * @return The number of intervals in the set.
+     */
+    size_t Size() const;
+
+    /**
+     * @brief Checks whether the set currently keeps its intervals in an IntervalTree.
+     * @return True above the threshold, false while the intervals are scanned flat.
+     */
+    bool IsTree() const;
+
+  private:
+    IntervalSimd::FlatIntervals<T, V> flat; ///< Holds the intervals while the set is at or below the threshold.
+    IntervalTree<T, V, A> tree; ///< Holds the intervals while the set is above the threshold.
+    size_t threshold; ///< The size above which the set becomes a tree.
+    bool large; ///< True while the intervals live in tree.
+
+    void ToTree(); ///< Bulk loads the flat intervals into the tree.
+    void ToFlat(); ///< Moves the intervals of the tree back into the flat arrays.
+
+    /**
+     * @brief Visits overlapping flat intervals with a given range.
+     * @return False if the visitor stopped the query.
+     */
+    template <typename Visitor>
+    bool Scan(T low, T high, Visitor& visit) const;
+};
+
+
+template <typename T, typename V, typename A>
+void SmallIntervalSet<T, V, A>::Insert(T low, T high, V data)
+{
+  Insert(Interval<T>(low, high), std::move(data));
+}
+
+template <typename T, typename V, typename A>
+void SmallIntervalSet<T, V, A>::Insert(Interval<T> i, V data)
+{
+  if(i.low > i.high)
+  {
+    throw std::invalid_argument("Invalid interval: low must be less than or equal to high.");
+  }
+  if(large)
+  {
+    tree.Insert(i, std::move(data));
+    return;
+  }
+  flat.Append(i.low, i.high, std::move(data));
+  if(flat.Size() > threshold)
+  {
+    ToTree();
+  }
+}
+
+template <typename T, typename V, typename A>
+bool SmallIntervalSet<T, V, A>::Remove(Interval<T> i)
+{
+  if(large)
+  {
+    if(!tree.Remove(i))
+    {
+      return false;
+    }
+    if(tree.Size() <= threshold / 2)
+    {
+      ToFlat();
+    }
+    return true;
+  }
+
+  return flat.Remove(i.low, i.high);
+}
+
+template <typename T, typename V, typename A>
+std::vector<std::pair<Interval<T>, V> > SmallIntervalSet<T, V, A>::Containing(T value) const
+{
+  return Overlapping(value, value);
+}
+
+template <typename T, typename V, typename A>
+std::vector<std::pair<Interval<T>, V> > SmallIntervalSet<T, V, A>::Overlapping(T low, T high) const
+{
+  if(large)
+  {
+    return tree.Overlapping(low, high);
+  }
+  std::vector<std::pair<Interval<T>, V> > result;
+  auto collect = [&result](const Interval<T>& i, const V& payload)
+  {
+    result.emplace_back(i, payload);
+  };
+  Scan(low, high, collect);
+  return result;
+}
+
+template <typename T, typename V, typename A>
+template <typename Visitor>
+void SmallIntervalSet<T, V, A>::ForEachOverlapping(T low, T high, Visitor visit) const
+{
+  if(large)
+  {
+    tree.ForEachOverlapping(low, high, visit);
+    return;
+  }
+  Scan(low, high, visit);
+}
+
+template <typename T, typename V, typename A>
+bool SmallIntervalSet<T, V, A>::Contains(T value) const
+{
+  return Overlaps(value, value);
+}
+
+template <typename T, typename V, typename A>
+bool SmallIntervalSet<T, V, A>::Overlaps(T low, T high) const
+{
+  if(large)
+  {
+    return tree.Overlaps(low, high);
+  }
+  bool found = false;
+  auto stop = [&found](const Interval<T>&, const V&)
+  {
+    found = true;
+    return false;
+  };
+  Scan(low, high, stop);
+  return found;
+}
+
+template <typename T, typename V, typename A>
+void SmallIntervalSet<T, V, A>::Clear()
+{
+  tree.Clear();
+  flat.Clear();
+  large = false;
+}
+
+template <typename T, typename V, typename A>
+bool SmallIntervalSet<T, V, A>::IsEmpty() const
+{
+  return Size() == 0;
+}
+
+template <typename T, typename V, typename A>
+size_t SmallIntervalSet<T, V, A>::Size() const
+{
+  return large ? tree.Size() : flat.Size();
+}
+
+template <typename T, typename V, typename A>
+bool SmallIntervalSet<T, V, A>::IsTree() const
+{
+  return large;
+}
+
+template <typename T, typename V, typename A>
+void SmallIntervalSet<T, V, A>::ToTree()
+{
+  std::vector<std::pair<Interval<T>, V> > entries;
+  entries.reserve(flat.Size());
+  for(size_t n = 0; n < flat.Size(); ++n)
+  {
+    entries.emplace_back(Interval<T>(flat.Low(n), flat.High(n)), std::move(flat.Data(n)));
+  }
+  tree.BulkInsert(entries);
+
+  flat.Clear();
+  large = true;
+}
+
+template <typename T, typename V, typename A>
+void SmallIntervalSet<T, V, A>::ToFlat()
+{
+  std::vector<std::pair<Interval<T>, V> > entries = tree.Intervals();
+  tree.Clear();
+  large = false;
+  for(size_t n = 0; n < entries.size(); ++n)
+  {
+    flat.Append(entries[n].first.low, entries[n].first.high, std::move(entries[n].second));
+  }
+}
+
+template <typename T, typename V, typename A>
+template <typename Visitor>
+bool SmallIntervalSet<T, V, A>::Scan(T low, T high, Visitor& visit) const
+{
+  return flat.Scan(low, high, [&visit](T l, T h, const V& payload)
+  {
+    return IntervalTreeDetail::Visit(visit, Interval<T>(l, h), payload);
+  });
+}
+#endif
@@ -0,0 +1,485 @@
+//---------------------------------------------------------------------------
+
+#ifndef StaticIntervalIndexH
+#define StaticIntervalIndexH
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "IntervalTree.h"
+#include "IntervalIndexFile.h"
+
+namespace IntervalTreeDetail
+{
+  /**
+   * @brief The queries of an implicit tree in Eytzinger order, over arrays owned elsewhere.
+   *
+   * StaticIntervalIndex points it at its vectors and MappedIntervalIndex at the
+   * arrays of a mapped file, so both answer queries with the same code.
+   */
+  template <typename T, typename V>
+  struct EytzingerView
+  {
+    const T* lows; ///< Interval low bounds.
+    const T* highs; ///< Interval high bounds.
+    const T* maxes; ///< The maximum high of the implicit subtree rooted at each slot.
+    const V* data; ///< The data of each interval.
+    size_t count; ///< The number of slots.
+
+    static const int MaxDepth = 64; ///< An implicit tree over size_t slots is never deeper than this.
+
+    typedef size_t Ref; ///< A node is its slot, for IntervalTreeDetail::InterleavedContaining.
+
+    size_t Root() const { return 0; }
+    bool Valid(size_t slot) const { return slot < count; }
+    const T& Low(size_t slot) const { return lows[slot]; }
+    const T& High(size_t slot) const { return highs[slot]; }
+    const T& Max(size_t slot) const { return maxes[slot]; }
+    static size_t Left(size_t slot) { return 2 * slot + 1; }
+    static size_t Right(size_t slot) { return 2 * slot + 2; }
+
+    /**
+     * @brief Gets the number of levels of the implicit tree.
+     */
+    int Depth() const
+    {
+      int depth = 0;
+      for(size_t n = count; n > 0; n >>= 1)
+      {
+        ++depth;
+      }
+      return depth;
+    }
+
+    /**
+     * @brief Starts loading the three keys of a slot; they sit in separate arrays.
+     */
+    void Prefetch(size_t slot) const
+    {
+      IntervalTreeDetail::Prefetch(lows + slot);
+      IntervalTreeDetail::Prefetch(highs + slot);
+      IntervalTreeDetail::Prefetch(maxes + slot);
+    }
+
+    /**
+     * @brief Finds the intervals containing each of a batch of points with interleaved walks.
+     */
+    IntervalBatchResult<T, V> ContainingInterleaved(const T* points, size_t pointCount, size_t group) const
+    {
+      std::vector<std::pair<size_t, size_t> > found;
+      InterleavedContaining(*this, points, pointCount, group, found);
+
+      IntervalBatchResult<T, V> result;
+      GatherBatch(found, pointCount, result,
+        [this](size_t slot) { return std::make_pair(Interval<T>(lows[slot], highs[slot]), data[slot]); });
+      return result;
+    }
+
+    /**
+     * @brief Checks if any intervals overlap with a given range.
+     */
+    bool Overlaps(T low, T high) const
+    {
+      size_t slot = 0;
+      while(slot < count && maxes[slot] >= low)
+      {
+        if(lows[slot] <= high && highs[slot] >= low)
+        {
+          return true;
+        }
+
+        // If the left subtree reaches low but holds no overlap, nothing to the right can overlap either
+        size_t left = 2 * slot + 1;
+        if(left < count && maxes[left] >= low)
+        {
+          slot = left;
+        }
+        else if(lows[slot] <= high)
+        {
+          slot = left + 1;
+        }
+        else
+        {
+          break;
+        }
+      }
+      return false;
+    }
+
+    /**
+     * @brief Visits overlapping intervals with a given range.
+     * @return False if the visitor stopped the query.
+     */
+    template <typename Visitor>
+    bool FindOverlapping(T low, T high, Visitor& visit) const
+    {
+      size_t stack[MaxDepth + 1];
+      int top = 0;
+      if(count > 0)
+      {
+        stack[top++] = 0;
+      }
+
+      while(top > 0)
+      {
+        size_t slot = stack[--top];
+        if(maxes[slot] < low)
+        {
+          continue; // Nothing in this subtree reaches the query
+        }
+
+        if(lows[slot] <= high)
+        {
+          if(highs[slot] >= low && !Visit(visit, Interval<T>(lows[slot], highs[slot]), data[slot]))
+          {
+            return false;
+          }
+          if(2 * slot + 2 < count)
+          {
+            stack[top++] = 2 * slot + 2; // Right lows are >= lows[slot], so they can only overlap if it is <= high
+          }
+        }
+        if(2 * slot + 1 < count)
+        {
+          stack[top++] = 2 * slot + 1;
+        }
+      }
+      return true;
+    }
+  };
+}
+
+/**
+ * @tparam T The type of the interval bounds.
+ * @tparam V The type of the payload stored with each interval.
+ * @class StaticIntervalIndex
+ * @brief An immutable interval index stored as an implicit tree in Eytzinger (BFS) order.
+ *
+ * The intervals are sorted by low and laid out so that the children of slot k
+ * are slots 2k + 1 and 2k + 2. The low, high and subtree max values live in
+ * separate arrays, so a query touches only the keys it compares and the top
+ * levels of the tree share a handful of cache lines. There are no pointers to
+ * chase: a child's position is computed, not loaded.
+ *
+ * The index is built once, either frozen from an IntervalTree or from a range,
+ * and answers the same queries as IntervalTree. Concurrent queries are safe.
+ */
+template <typename T = int, typename V = std::shared_ptr<T> >
+class StaticIntervalIndex
+{
+  public:
+    StaticIntervalIndex() {} ///< Constructs an empty index.
+
+    /**
+     * @brief Freezes the current contents of an IntervalTree into an index.
+     * @param tree The tree to copy the intervals and data from.
+     */
+    template <typename A, typename S>
+    explicit StaticIntervalIndex(const IntervalTree<T, V, A, S>& tree);
+
+    /**
+     * @brief Builds an index from a range of intervals in O(n log n).
+     * @param first The beginning of the range of Interval<T> or std::pair<Interval<T>, V> elements.
+     * @param last The end of the range.
+     */
+    template <typename Iter>
+    StaticIntervalIndex(Iter first, Iter last);
+
+    /**
+     * @brief Finds all intervals that contain a specific value.
+     * @param value The value to check for containment.
+     * @return A vector of intervals that contain the specified value.
+     */
+    std::vector<std::pair<Interval<T>, V> > Containing(T value) const;
+
+    /**
+     * @brief Finds the intervals containing each of a batch of points, interleaving one walk per point to hide memory latency.
+     *
+     * Up to group walks are in flight and take turns advancing one slot,
+     * prefetching the keys of the slots they visit next; see
+     * IntervalTree::ContainingInterleaved.
+     *
+     * @param points The query points, in any order.
+     * @param count The number of query points.
+     * @param group The number of walks in flight.
+     * @return The hits of each point, in the order the points were given.
+     */
+    IntervalBatchResult<T, V> ContainingInterleaved(const T* points, size_t count, size_t group = 16) const;
+
+    /**
+     * @brief Finds all intervals that overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return A vector of intervals that overlap with the specified range.
+     */
+    std::vector<std::pair<Interval<T>, V> > Overlapping(T low, T high) const;
+
+    /**
+     * @brief Checks if a specific value is contained within any interval.
+     * @param value The value to check.
+     * @return True if the value is contained in any interval, false otherwise.
+     */
+    bool Contains(T value) const;
+
+    /**
+     * @brief Checks if any intervals overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return True if there are overlapping intervals, false otherwise.
+     */
+    bool Overlaps(T low, T high) const;
+
+    /**
+     * @brief Writes the index to a file that Load and MappedIntervalIndex read back; see IntervalIndexFile.
+     *
+     * Only arithmetic keys and trivially copyable payloads can be saved.
+     *
+     * @param path The file to create or overwrite.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void Save(const std::string& path) const;
+
+    /**
+     * @brief Reads an index written by Save, without sorting or rebuilding.
+     * @param path The file to read.
+     * @return The index stored in the file.
+     * @throws std::runtime_error if the file cannot be read, is corrupt, or holds other key or payload types.
+     */
+    static StaticIntervalIndex<T, V> Load(const std::string& path);
+
+    /**
+     * @brief Checks whether the index is empty.
+     * @return True if the index holds no intervals, false otherwise.
+     */
+    bool IsEmpty(void) const;
+
+    /**
+     * @brief Gets the number of intervals in the index.
+     * @return The number of intervals in the index.
+     */
+    size_t Size() const;
+
+  private:
+    std::vector<T> lows; ///< Interval low bounds in Eytzinger order.
+    std::vector<T> highs; ///< Interval high bounds in Eytzinger order.
+    std::vector<T> maxes; ///< The maximum high of the implicit subtree rooted at each slot.
+    std::vector<V> data; ///< The data of each interval, kept apart from the search keys.
+
+    /**
+     * @brief Lays out entries sorted by low into the Eytzinger arrays and fills in the subtree maxima.
+     */
+    void Build(const std::vector<std::pair<Interval<T>, V> >& entries);
+
+    /**
+     * @brief Places sorted entries into the subtree rooted at slot by in-order traversal.
+     */
+    size_t Place(const std::vector<std::pair<Interval<T>, V> >& entries, size_t next, size_t slot);
+
+    /**
+     * @brief Points a query view at the arrays.
+     */
+    IntervalTreeDetail::EytzingerView<T, V> View() const
+    {
+      IntervalTreeDetail::EytzingerView<T, V> view = { lows.data(), highs.data(), maxes.data(), data.data(), lows.size() };
+      return view;
+    }
+
+    /**
+     * @brief Finds overlapping intervals with a given range.
+     */
+    void FindOverlapping(T low, T high, std::vector<std::pair<Interval<T>, V> >& result) const;
+
+    /**
+     * @brief Converts a bulk-load element to an index entry.
+     */
+    static std::pair<Interval<T>, V> MakeEntry(const Interval<T>& i)
+    {
+      return std::make_pair(i, V());
+    }
+
+    /**
+     * @brief Converts a bulk-load element to an index entry.
+     */
+    static std::pair<Interval<T>, V> MakeEntry(const std::pair<Interval<T>, V>& entry)
+    {
+      return entry;
+    }
+};
+
+
+template <typename T, typename V>
+template <typename A, typename S>
+StaticIntervalIndex<T, V>::StaticIntervalIndex(const IntervalTree<T, V, A, S>& tree)
+{
+  Build(tree.Intervals()); // Already sorted by low
+}
+
+template <typename T, typename V>
+template <typename Iter>
+StaticIntervalIndex<T, V>::StaticIntervalIndex(Iter first, Iter last)
+{
+  std::vector<std::pair<Interval<T>, V> > entries;
+  for(; first != last; ++first)
+  {
+    entries.push_back(MakeEntry(*first));
+    if(entries.back().first.low > entries.back().first.high)
+    {
+      throw std::invalid_argument("Invalid interval: low must be less than or equal to high.");
+    }
+  }
+  std::stable_sort(entries.begin(), entries.end(),
+    [](const std::pair<Interval<T>, V>& a, const std::pair<Interval<T>, V>& b)
+    {
+      return a.first.low < b.first.low;
+    });
+  Build(entries);
+}
+
+template <typename T, typename V>
+std::vector<std::pair<Interval<T>, V> > StaticIntervalIndex<T, V>::Containing(T value) const
+{
+  std::vector<std::pair<Interval<T>, V> > result;
+  FindOverlapping(value, value, result);
+  return result;
+}
+
+template <typename T, typename V>
+IntervalBatchResult<T, V> StaticIntervalIndex<T, V>::ContainingInterleaved(const T* points, size_t count, size_t group) const
+{
+  return View().ContainingInterleaved(points, count, group);
+}
+
+template <typename T, typename V>
+std::vector<std::pair<Interval<T>, V> > StaticIntervalIndex<T, V>::Overlapping(T low, T high) const
+{
+  std::vector<std::pair<Interval<T>, V> > result;
+  FindOverlapping(low, high, result);
+  return result;
+}
+
+template <typename T, typename V>
+bool StaticIntervalIndex<T, V>::Contains(T value) const
+{
+  return Overlaps(value, value);
+}
+
+template <typename T, typename V>
+bool StaticIntervalIndex<T, V>::Overlaps(T low, T high) const
+{
+  return View().Overlaps(low, high);
+}
+
+template <typename T, typename V>
+void StaticIntervalIndex<T, V>::Save(const std::string& path) const
+{
+  IntervalIndexFile::Write(path, lows.data(), highs.data(), maxes.data(), data.data(), lows.size());
+}
+
+template <typename T, typename V>
+StaticIntervalIndex<T, V> StaticIntervalIndex<T, V>::Load(const std::string& path)
+{
+  static_assert(std::is_trivially_copyable<V>::value, "Only trivially copyable payloads can be loaded.");
+
+  std::ifstream in(path.c_str(), std::ios::binary | std::ios::ate);
+  if(!in)
+  {
+    throw std::runtime_error("Cannot open interval index file: " + path);
+  }
+  uint64_t size = static_cast<uint64_t>(in.tellg());
+  IntervalIndexFile::Header header;
+  in.seekg(0);
+  in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  IntervalIndexFile::Validate<T, V>(header, in ? size : 0, path);
+
+  // The arrays are already in Eytzinger order with their maxima, so they are read straight into place
+  StaticIntervalIndex<T, V> index;
+  const size_t n = static_cast<size_t>(header.count);
+  index.lows.resize(n);
+  index.highs.resize(n);
+  index.maxes.resize(n);
+  index.data.resize(n);
+  in.seekg(static_cast<std::streamoff>(header.lowsOffset));
+  in.read(reinterpret_cast<char*>(index.lows.data()), static_cast<std::streamsize>(n * sizeof(T)));
+  in.seekg(static_cast<std::streamoff>(header.highsOffset));
+  in.read(reinterpret_cast<char*>(index.highs.data()), static_cast<std::streamsize>(n * sizeof(T)));
+  in.seekg(static_cast<std::streamoff>(header.maxesOffset));
+  in.read(reinterpret_cast<char*>(index.maxes.data()), static_cast<std::streamsize>(n * sizeof(T)));
+  in.seekg(static_cast<std::streamoff>(header.dataOffset));
+  in.read(reinterpret_cast<char*>(index.data.data()), static_cast<std::streamsize>(n * sizeof(V)));
+  if(!in)
+  {
+    throw std::runtime_error("Cannot read interval index file: " + path);
+  }
+  return index;
+}
+
+template <typename T, typename V>
+bool StaticIntervalIndex<T, V>::IsEmpty() const
+{
+  return lows.empty();
+}
+
+template <typename T, typename V>
+size_t StaticIntervalIndex<T, V>::Size() const
+{
+  return lows.size();
+}
+
+template <typename T, typename V>
+void StaticIntervalIndex<T, V>::Build(const std::vector<std::pair<Interval<T>, V> >& entries)
+{
+  const size_t n = entries.size();
+  lows.resize(n);
+  highs.resize(n);
+  maxes.resize(n);
+  data.resize(n);
+  Place(entries, 0, 0);
+
+  // Children always sit at higher slots than their parent, so one backwards sweep computes every subtree max
+  for(size_t slot = n; slot-- > 0; )
+  {
+    T max = highs[slot];
+    size_t left = 2 * slot + 1;
+    if(left < n)
+    {
+      max = std::max(max, maxes[left]);
+    }
+    if(left + 1 < n)
+    {
+      max = std::max(max, maxes[left + 1]);
+    }
+    maxes[slot] = max;
+  }
+}
+
+template <typename T, typename V>
+size_t StaticIntervalIndex<T, V>::Place(const std::vector<std::pair<Interval<T>, V> >& entries,
+  size_t next, size_t slot)
+{
+  if(slot >= entries.size())
+  {
+    return next;
+  }
+  next = Place(entries, next, 2 * slot + 1);
+  lows[slot] = entries[next].first.low;
+  highs[slot] = entries[next].first.high;
+  data[slot] = entries[next].second;
+  return Place(entries, next + 1, 2 * slot + 2);
+}
+
+template <typename T, typename V>
+void StaticIntervalIndex<T, V>::FindOverlapping(T low, T high,
+  std::vector<std::pair<Interval<T>, V> >& result) const
+{
+  auto collect = [&result](const Interval<T>& i, const V& payload)
+  {
+    result.emplace_back(i, payload);
+  };
+  View().FindOverlapping(low, high, collect);
+}
+#endif
@@ -0,0 +1,361 @@
+//---------------------------------------------------------------------------
+
+#ifndef WideIntervalIndexH
+#define WideIntervalIndexH
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "IntervalTree.h"
+#include "IntervalSimd.h"
+
+/**
+ * @tparam T The type of the interval bounds.
+ * @tparam V The type of the payload stored with each interval.
+ * @class WideIntervalIndex
+ * @brief An immutable interval index of wide nodes, each testing a whole block of keys in one SIMD compare.
+ *
+ * The intervals are sorted by low and cut into leaf blocks of
+ * IntervalSimd::Width, whose lows and highs sit in cache-line-aligned arrays.
+ * Each internal node holds the lowest low and the subtree max of up to Width
+ * children, so one OverlapMask call decides which children a query enters. A
+ * binary tree pays one dependent cache miss per level. With 8-way nodes the
+ * tree is about three times shallower, and each level is a block the
+ * prefetcher reads in one go.
+ *
+ * The index is built once, from an IntervalTree or from a range, and answers
+ * the same queries as StaticIntervalIndex. Concurrent queries are safe.
+ */
+template <typename T = int, typename V = std::shared_ptr<T> >
+class WideIntervalIndex
+{
+  public:
+    WideIntervalIndex() : count(0) {} ///< Constructs an empty index.
+
+    /**
+     * @brief Freezes the current contents of an IntervalTree into an index.
+     * @param tree The tree to copy the intervals and data from.
+     */
+    template <typename A, typename S>
+    explicit WideIntervalIndex(const IntervalTree<T, V, A, S>& tree);
+
+    /**
+     * @brief Builds an index from a range of intervals in O(n log n).
+     * @param first The beginning of the range of Interval<T> or std::pair<Interval<T>, V> elements.
+     * @param last The end of the range.
+     */
+    template <typename Iter>
+    WideIntervalIndex(Iter first, Iter last);
+
+    /**
+     * @brief Finds all intervals that contain a specific value.
+     * @param value The value to check for containment.
+     * @return A vector of intervals that contain the specified value.
+     */
+    std::vector<std::pair<Interval<T>, V> > Containing(T value) const;
+
+    /**
+     * @brief Finds all intervals that overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return A vector of intervals that overlap with the specified range.
+     */
+    std::vector<std::pair<Interval<T>, V> > Overlapping(T low, T high) const;
+
+    /**
+     * @brief Calls a visitor for every interval that overlaps with a given range, in ascending order of low.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @param visit The callable invoked as visit(const Interval<T>&, const V&); returning false stops the query.
+     */
+    template <typename Visitor>
+    void ForEachOverlapping(T low, T high, Visitor visit) const;
+
+    /**
+     * @brief Checks if a specific value is contained within any interval.
+     * @param value The value to check.
+     * @return True if the value is contained in any interval, false otherwise.
+     */
+    bool Contains(T value) const;
+
+    /**
+     * @brief Checks if any intervals overlap with a given range.
+     * @param low The lower bound of the range.
+     * @param high The upper bound of the range.
+     * @return True if there are overlapping intervals, false otherwise.
+     */
+    bool Overlaps(T low, T high) const;
+
+    /**
+     * @brief Checks whether the index is empty.
+     * @return True if the index holds no intervals, false otherwise.
+     */
+    bool IsEmpty(void) const;
+
+    /**
+     * @brief Gets the number of intervals in the index.
+     * @return The number of intervals in the index.
+     */
+    size_t Size() const;
+
+    /**
+     * @brief Gets the number of levels, the leaf blocks included.
+     * @return The depth of every descent, 0 for an empty index.
+     */
+    size_t Depth() const;
+
+  private:
+    typedef IntervalKeyTraits<T> Traits;
+    typedef typename Traits::Key Key; ///< Integral keys are widened to 32 or 64 bits so the SIMD kernels apply.
+    typedef std::vector<Key, IntervalSimd::AlignedAllocator<Key> > KeyArray;
+
+    /**
+     * @brief One level of internal nodes: the summaries of the nodes or leaf blocks below, Width per node.
+     */
+    struct Level
+    {
+      KeyArray minLows; ///< The lowest low of each child.
+      KeyArray maxes; ///< The highest high of each child.
+      size_t children; ///< The number of valid child summaries; the rest of the last node is padding.
+    };
+
+    KeyArray lows; ///< Interval low bounds in ascending order, padded to whole blocks.
+    KeyArray highs; ///< Interval high bounds, in the order of lows.
+    std::vector<V> data; ///< The data of each interval, kept apart from the search keys.
+    std::vector<Level> levels; ///< Internal levels, from the one above the leaves up to the single root node.
+    size_t count; ///< The number of intervals.
+
+    static const int MaxLevels = 24; ///< 8^22 exceeds any size_t count, so the traversal stack never overflows.
+
+    /**
+     * @brief Lays out entries sorted by low in leaf blocks and builds the levels above them.
+     */
+    void Build(std::vector<std::pair<Interval<T>, V> >& entries);
+
+    /**
+     * @brief Masks off the lanes of a block at or past the end of its array.
+     */
+    static unsigned Valid(size_t begin, size_t end)
+    {
+      return end - begin >= IntervalSimd::Width ? (1u << IntervalSimd::Width) - 1 : (1u << (end - begin)) - 1;
+    }
+
+    /**
+     * @brief Visits overlapping intervals with a given range.
+     * @return False if the visitor stopped the query.
+     */
+    template <typename Visitor>
+    bool FindOverlapping(T low, T high, Visitor& visit) const;
+
+    /**
+     * @brief Converts a bulk-load element to an index entry.
+     */
+    static std::pair<Interval<T>, V> MakeEntry(const Interval<T>& i)
+    {
+      return std::make_pair(i, V());
+    }
+
+    /**
+     * @brief Converts a bulk-load element to an index entry.
+     */
+    static std::pair<Interval<T>, V> MakeEntry(const std::pair<Interval<T>, V>& entry)
+    {
+      return entry;
+    }
+};
+
+
+template <typename T, typename V>
+template <typename A, typename S>
+WideIntervalIndex<T, V>::WideIntervalIndex(const IntervalTree<T, V, A, S>& tree) : count(0)
+{
+  std::vector<std::pair<Interval<T>, V> > entries = tree.Intervals(); // Already sorted by low
+  Build(entries);
+}
+
+template <typename T, typename V>
+template <typename Iter>
+WideIntervalIndex<T, V>::WideIntervalIndex(Iter first, Iter last) : count(0)
+{
+  std::vector<std::pair<Interval<T>, V> > entries;
+  for(; first != last; ++first)
+  {
+    entries.push_back(MakeEntry(*first));
+    if(entries.back().first.low > entries.back().first.high)
+    {
+      throw std::invalid_argument("Invalid interval: low must be less than or equal to high.");
+    }
+  }
+  std::stable_sort(entries.begin(), entries.end(),
+    [](const std::pair<Interval<T>, V>& a, const std::pair<Interval<T>, V>& b)
+    {
+      return a.first.low < b.first.low;
+    });
+  Build(entries);
+}
+
+template <typename T, typename V>
+std::vector<std::pair<Interval<T>, V> > WideIntervalIndex<T, V>::Containing(T value) const
+{
+  return Overlapping(value, value);
+}
+
+template <typename T, typename V>
+std::vector<std::pair<Interval<T>, V> > WideIntervalIndex<T, V>::Overlapping(T low, T high) const
+{
+  std::vector<std::pair<Interval<T>, V> > result;
+  ForEachOverlapping(low, high, [&result](const Interval<T>& i, const V& payload)
+  {
+    result.emplace_back(i, payload);
+  });
+  return result;
+}
+
+template <typename T, typename V>
+template <typename Visitor>
+void WideIntervalIndex<T, V>::ForEachOverlapping(T low, T high, Visitor visit) const
+{
+  FindOverlapping(low, high, visit);
+}
+
+template <typename T, typename V>
+bool WideIntervalIndex<T, V>::Contains(T value) const
+{
+  return Overlaps(value, value);
+}
+
+template <typename T, typename V>
+bool WideIntervalIndex<T, V>::Overlaps(T low, T high) const
+{
+  bool found = false;
+  auto stop = [&found](const Interval<T>&, const V&)
+  {
+    found = true;
+    return false;
+  };
+  FindOverlapping(low, high, stop);
+  return found;
+}
+
+template <typename T, typename V>
+bool WideIntervalIndex<T, V>::IsEmpty() const
+{
+  return count == 0;
+}
+
+template <typename T, typename V>
+size_t WideIntervalIndex<T, V>::Size() const
+{
+  return count;
+}
+
+template <typename T, typename V>
+size_t WideIntervalIndex<T, V>::Depth() const
+{
+  return count == 0 ? 0 : levels.size() + 1;
+}
+
+template <typename T, typename V>
+void WideIntervalIndex<T, V>::Build(std::vector<std::pair<Interval<T>, V> >& entries)
+{
+  const size_t width = IntervalSimd::Width;
+  count = entries.size();
+  if(count == 0)
+  {
+    return;
+  }
+
+  // Padding lanes keep Key() and are masked off by Valid, so no sentinel key is needed
+  size_t blocks = (count + width - 1) / width;
+  lows.assign(blocks * width, Key());
+  highs.assign(blocks * width, Key());
+  data.reserve(count);
+  for(size_t n = 0; n < count; ++n)
+  {
+    lows[n] = Traits::Encode(entries[n].first.low);
+    highs[n] = Traits::Encode(entries[n].first.high);
+    data.push_back(std::move(entries[n].second));
+  }
+
+  // Summarize the leaf blocks, then each level of nodes, until one node covers everything
+  size_t children = blocks;
+  const KeyArray* belowLows = &lows;
+  const KeyArray* belowHighs = &highs;
+  size_t belowCount = count;
+  do
+  {
+    Level level;
+    size_t nodes = (children + width - 1) / width;
+    level.minLows.assign(nodes * width, Key());
+    level.maxes.assign(nodes * width, Key());
+    level.children = children;
+    for(size_t c = 0; c < children; ++c)
+    {
+      size_t begin = c * width;
+      size_t end = std::min(begin + width, belowCount);
+      level.minLows[c] = (*belowLows)[begin]; // Children are sorted by low, so their first low is the lowest
+      level.maxes[c] = *std::max_element(belowHighs->begin() + begin, belowHighs->begin() + end);
+    }
+    levels.push_back(std::move(level));
+    belowLows = &levels.back().minLows;
+    belowHighs = &levels.back().maxes;
+    belowCount = children;
+    children = nodes;
+  } while(children > 1);
+}
+
+template <typename T, typename V>
+template <typename Visitor>
+bool WideIntervalIndex<T, V>::FindOverlapping(T low, T high, Visitor& visit) const
+{
+  if(count == 0)
+  {
+    return true;
+  }
+
+  const size_t width = IntervalSimd::Width;
+  const Key lowKey = Traits::Encode(low);
+  const Key highKey = Traits::Encode(high);
+  std::pair<size_t, size_t> stack[MaxLevels * IntervalSimd::Width]; // (level, node)
+  int top = 0;
+  stack[top++] = std::make_pair(levels.size() - 1, size_t(0));
+
+  while(top > 0)
+  {
+    std::pair<size_t, size_t> entry = stack[--top];
+    const Level& level = levels[entry.first];
+    size_t base = entry.second * width;
+    unsigned mask = IntervalSimd::OverlapMask(&level.minLows[base], &level.maxes[base], lowKey, highKey) &
+                    Valid(base, level.children);
+
+    if(entry.first == 0)
+    {
+      // The children are leaf blocks: test their intervals right away, in ascending order
+      for(; mask; mask &= mask - 1)
+      {
+        size_t block = (base + IntervalSimd::LowestBit(mask)) * width;
+        unsigned hits = IntervalSimd::OverlapMask(&lows[block], &highs[block], lowKey, highKey) & Valid(block, count);
+        for(; hits; hits &= hits - 1)
+        {
+          size_t n = block + IntervalSimd::LowestBit(hits);
+          if(!IntervalTreeDetail::Visit(visit, Interval<T>(Traits::Decode(lows[n]), Traits::Decode(highs[n])), data[n]))
+          {
+            return false;
+          }
+        }
+      }
+      continue;
+    }
+
+    // Push the highest child first so the lowest is visited first
+    for(; mask; mask &= ~(1u << IntervalSimd::HighestBit(mask)))
+    {
+      stack[top++] = std::make_pair(entry.first - 1, base + IntervalSimd::HighestBit(mask));
+    }
+  }
+  return true;
+}
+#endif